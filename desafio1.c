@@ -1,11 +1,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
-#include <signal.h>
-#include <sys/wait.h>
-#include <string.h>
 #include <time.h>
 
+#include "tokenring.h"
+
+#ifndef VERSION
+#define VERSION "desconocida"
+#endif
+
 /*
  * Autores: Omar Elias Saez Arias y Enzo Ivo San Martin Pavez
  * Proyecto: Laboratorio de procesos en anillo - Simulación de paso de token con señales
@@ -13,13 +16,15 @@
  * Descripción general de la idea:
  *
  * 1. El proceso padre comienza creando todos los procesos hijos necesarios y guarda sus PIDs.
+ *    Por defecto los hijos se crean con clone(CLONE_VM) sobre una pila pequeña propia, asi comparten
+ *    la memoria del padre en vez de copiar sus tablas de paginas como con fork() (-L fork).
  *
  * 2. Una vez que todos los hijos están creados, el padre les envía a cada uno la lista completa
  *    de PIDs. Cada hijo, al recibirla, identifica cuál es su propio PID y así determina quién es
  *    su "siguiente" en el anillo.
  *
  * 3. Solo uno de los procesos recibe inicialmente el "token" (un número entero). Ese token es
- *    pasado de un proceso a otro en forma de señales, simulando el movimiento en anillo.
+ *    pasado de un proceso a otro en forma de señales (o por FIFOs con -T fifo), simulando el movimiento en anillo.
  *
  * 4. Cada vez que un proceso recibe el token, lo reduce en un número aleatorio. Si el token se
  *    vuelve negativo, ese proceso se "elimina" a sí mismo y avisa al padre que ha muerto.
@@ -34,88 +39,81 @@
  * 7. El proceso padre permanece vivo durante toda la ejecución, monitoreando todo el sistema y
  *    finaliza solo cuando el declara un ganador.
  *
+ * Con -k <tokens> circulan varios tokens a la vez, repartidos en el anillo. Cada token sigue las
+ * mismas reglas: el que elimina a un proceso vuelve a empezar con el valor original, desde su
+ * posicion de partida. Con un solo token esa posicion es el primero de la lista, como siempre.
+ *
+ * Si un hijo muere sin haber sido eliminado (por ejemplo con kill -9) el padre lo saca del anillo
+ * igual que a un eliminado y vuelve a lanzar todos los tokens, porque no sabe cuales tenia el caido.
+ * Con -R se imprime la version (git describe al compilar) y cada evento con su instante, en el formato
+ * que lee el arnes de estres (estres.c).
+ *
+ * Todo lo comun (crear el anillo, pasar el token, repararlo, transportes y sondas USDT) vive en
+ * libtokenring (tokenring.c); este programa solo define la regla del juego y lo que se imprime.
+ *
  */
 
-// Variables globales
-pid_t next_pid = -1;
-int token = -1;
-int max_decremento = 0;
-pid_t mi_pid;
-pid_t padre_pid;
-int token_inicial = -1;
+// Entradas: salto actual (token recibido y semilla del proceso) y argumentos del programa
+// Salidas: token resultante, negativo si el proceso queda eliminado
+// Descripción: Decrementa el token de forma aleatoria y lo imprime. Corre dentro de cada hijo
+int decrementar(anillo_salto_t *salto, void *contexto) {
+    const anillo_argumentos_t *argumentos = contexto;
+    int decremento = rand_r(&salto->semilla) % (argumentos->max_decremento + 1);
+    int resultante = salto->valor - decremento;
 
-pid_t *pids;
-int n_procesos = -1;
+    if (argumentos->silencioso) return resultante;
 
-// Entradas: señal SIGUSR1 con el valor del PID del siguiente proceso
-// Salidas: ninguna
-// Descripción: Manejador que asigna el PID del siguiente proceso en el anillo a la variable global next_pid
-void recibir_siguiente(int sig, siginfo_t *info, void *context) {
-    next_pid = info->si_value.sival_int;
+    if (argumentos->tokens == 1) {
+        anillo_escribir("\nProceso %d ; Token recibido: %d ; Token resultante: %d ", salto->yo, salto->valor, resultante);
+    } else {
+        anillo_escribir("\nProceso %d ; Token %d recibido: %d ; Token resultante: %d ", salto->yo, salto->id, salto->valor, resultante);
+    }
+    return resultante;
 }
 
-// Entradas: señal SIGUSR2 con el valor del token
-// Salidas: ninguna
-// Descripción: Decrementa el token de forma aleatoria, lo imprime y lo pasa al siguiente proceso. Si el token es negativo, lo envía al padre y termina el proceso
-void manejar_token(int sig, siginfo_t *info, void *context) {
-    token = info->si_value.sival_int;
-
-    printf("\nProceso %d ; Token recibido: %d ; ", getpid(), token);
-    fflush(stdout);
-
-    int decremento = rand() % (max_decremento + 1);
-    token -= decremento;
+// Entradas: anillo, id del token y cantidad de tokens
+// Salidas: posicion del anillo donde parte ese token
+// Descripción: Reparte los tokens a distancias iguales en el anillo actual. El token 0 siempre parte en el primero de la lista
+int posicion_de_partida(anillo_t *anillo, int id, int tokens) {
+    return (int)((long long)id * anillo_miembros(anillo) / tokens);
+}
 
-    printf("Token resultante: %d ", token);
+// Entradas: argumentos del programa, nombre del evento, PID, instante (CLOCK_MONOTONIC) en nanosegundos, id del token y ronda
+// Salidas: ninguna
+// Descripción: Con -R imprime una linea "evento,<nombre>,<pid>,<ns>,<id>,<ronda>" y la envia de inmediato
+void reportar(const anillo_argumentos_t *argumentos, const char *nombre, pid_t pid, long long ns, int id, int ronda) {
+    if (!argumentos->reporte) return;
+    printf("evento,%s,%d,%lld,%d,%d\n", nombre, pid, ns, id, ronda);
     fflush(stdout);
-
-    if (token < 0) {
-        sigqueue(padre_pid, SIGUSR2, (union sigval){ .sival_int = token });
-        exit(0);
-    } else {
-        sigqueue(next_pid, SIGUSR2, (union sigval){ .sival_int = token });
-    }
 }
 
-// Entradas: señal SIGUSR2 con valor del token negativo y el PID del proceso que murió
+// Entradas: argumentos del programa y estadisticas del anillo
 // Salidas: ninguna
-// Descripción: El padre elimina el proceso que recibió un token negativo, reorganiza el anillo, le manda el nuevo PID al ante proceso eliminado y si solo queda uno, lo declara ganador y termina
-void padre_maneja_token_negativo(int sig, siginfo_t *info, void *context) {
-    pid_t muerto = info->si_pid;
-    int token_negativo = info->si_value.sival_int;
-
-    printf("(Proceso %d es eliminado)", muerto);
+// Descripción: Con -R imprime la linea final "estadisticas,<miembros>,<eliminados>,<caidos>,<huerfanos>,<obsoletos>,<rechazados>,<fallos_lanzamiento>"
+void reportar_estadisticas(const anillo_argumentos_t *argumentos, const anillo_estadisticas_t *estadisticas) {
+    if (!argumentos->reporte) return;
+    printf("estadisticas,%d,%d,%d,%d,%d,%d,%d\n", estadisticas->miembros, estadisticas->eliminados,
+           estadisticas->caidos, estadisticas->huerfanos, estadisticas->obsoletos, estadisticas->rechazados,
+           estadisticas->fallos_lanzamiento);
     fflush(stdout);
+}
 
-    int index_muerto = -1;
-    for (int i = 0; i < n_procesos; i++) {
-        if (pids[i] == muerto) {
-            index_muerto = i;
-            break;
-        }
-    }
-    if (index_muerto == -1) return;
-
-    pid_t anterior = pids[(index_muerto - 1 + n_procesos) % n_procesos];
-    pid_t siguiente = pids[(index_muerto + 1) % n_procesos];
-
-    if (anterior == siguiente) {
-        printf("\nProceso %d es el ganador\n", anterior);
-        fflush(stdout);
-        kill(anterior, SIGTERM);
-        free(pids);
-        exit(0);
-    }
-
-    for (int i = index_muerto; i < n_procesos - 1; i++) {
-        pids[i] = pids[i + 1];
-    }
-    n_procesos--;
-
-    sigqueue(anterior, SIGUSR1, (union sigval){ .sival_int = siguiente });
-    usleep(100000);
+// Entradas: ninguna
+// Salidas: instante actual de CLOCK_MONOTONIC en nanosegundos
+// Descripción: Misma base de tiempo que los eventos del anillo
+long long ahora_ns() {
+    struct timespec ahora;
+    clock_gettime(CLOCK_MONOTONIC, &ahora);
+    return ahora.tv_sec * 1000000000LL + ahora.tv_nsec;
+}
 
-    sigqueue(pids[0], SIGUSR2, (union sigval){ .sival_int = token_inicial });
+// Entradas: anillo, id del token que debe volver a empezar y argumentos del programa
+// Salidas: ninguna
+// Descripción: Manda el token con el valor original desde su posicion de partida. Con -R se informa como "inyectado" (cada uno es la ronda siguiente)
+void reinyectar(anillo_t *anillo, int id, const anillo_argumentos_t *argumentos) {
+    int posicion = posicion_de_partida(anillo, id, argumentos->tokens);
+    reportar(argumentos, "inyectado", anillo_miembro(anillo, posicion), ahora_ns(), id, 0);
+    anillo_pasar_token(anillo, posicion, id, argumentos->token_inicial);
 }
 
 // Entrada: Ninguna
@@ -123,110 +121,138 @@ void padre_maneja_token_negativo(int sig, siginfo_t *info, void *context) {
 // Descripción: Función que muestra el correcto uso de argumentos para poder ejecutar el codigo y despues cierra el programa
 void mostrar_uso() {
     printf("Uso correcto:\n");
-    printf("./desafio1 -p <n_procesos> -M <max_decremento> -t <token_inicial>\n");
+    printf("./desafio1 -p <n_procesos> -M <max_decremento> -t <token_inicial> [-k <tokens>] [-s] [-m] [-R] [-T senales|fifo] [-L clone|fork]\n");
     printf("Ejemplo: ./desafio1 -p 5 -M 10 -t 50\n");
+    printf("  -k  cantidad de tokens circulando a la vez (por defecto 1)\n");
+    printf("  -s  modo silencioso: solo se imprime el ganador (util al trazar con las sondas USDT)\n");
+    printf("  -m  reporta el tiempo de creacion, la memoria (PSS) por hijo y las eliminaciones por segundo\n");
+    printf("  -R  imprime cada evento del anillo con su instante (formato del arnes de estres)\n");
+    printf("  -T  transporte de los mensajes (por defecto senales)\n");
+    printf("  -L  forma de crear los hijos (por defecto clone)\n");
     exit(1);
 }
 
-// Entradas: argumentos de línea de comandos -p (procesos), -M (máximo decremento), -t (token inicial)
+// Entradas: argumentos de línea de comandos -p (procesos), -M (máximo decremento), -t (token inicial) y los opcionales de mostrar_uso
 // Salidas: retorna 0 si termina correctamente
-// Descripción: Función principal que crea procesos hijos, establece manejadores, forma el anillo, y lanza el token inicial. Termina cuando queda un solo proceso.
+// Descripción: Función principal que arma el anillo, lanza el token inicial y atiende las eliminaciones hasta que queda un solo proceso.
 int main(int argc, char *argv[]) {
+    anillo_argumentos_t argumentos;
+    anillo_estadisticas_t estadisticas;
+    anillo_evento_t evento;
+    int hay_ganador = 0;
 
-    // Verificar cantidad de argumentos
-    if (argc != 7) {
-        printf("Error: Número incorrecto de argumentos.\n");
+    if (anillo_leer_argumentos(argc, argv, "pMt", &argumentos) != 0) {
         mostrar_uso();
     }
 
-    // Se verifica que los argumentos sean validos
-    for (int i = 1; i < argc; i++) {
-        if (strcmp(argv[i], "-p") == 0) {
-            n_procesos = atoi(argv[i + 1]);
-            if (n_procesos <= 1) {
-                printf("Error: El número de procesos (-p) debe ser mayor que 1.\n");
-                mostrar_uso();
-            }
-        } else if (strcmp(argv[i], "-M") == 0) {
-            max_decremento = atoi(argv[i + 1]);
-            if (max_decremento <= 0) {
-                printf("Error: El decremento máximo (-M) debe ser mayor que 0.\n");
-                mostrar_uso();
-            }
-        } else if (strcmp(argv[i], "-t") == 0) {
-            token_inicial = atoi(argv[i + 1]);
-            if (token_inicial <= 0) {
-                printf("Error: El valor inicial del token (-t) debe ser mayor que 0.\n");
-                mostrar_uso();
-            }
-        }
+    anillo_opciones_t opciones = {
+        .n_procesos = argumentos.n_procesos,
+        .transporte = argumentos.transporte,
+        .lanzador = argumentos.lanzador,
+    };
+    anillo_t *anillo = anillo_crear(&opciones);
+    if (anillo == NULL) {
+        printf("Error: No se pudo crear el anillo.\n");
+        exit(1);
     }
+    anillo_registrar_callback(anillo, decrementar, &argumentos);
 
-    // Verificación final de parámetros
-    if (n_procesos == -1 || max_decremento == -1 || token_inicial == -1) {
-        printf("Error: Faltan parámetros obligatorios.\n");
-        mostrar_uso();
+    // La version va antes de armar el anillo para que tambien quede en las corridas que no arrancan
+    if (argumentos.reporte) printf("version,%s\n", VERSION);
+
+    if (anillo_iniciar(anillo) != 0) {
+        anillo_estadisticas(anillo, &estadisticas);
+        reportar_estadisticas(&argumentos, &estadisticas);
+        if (estadisticas.miembros < argumentos.n_procesos) {
+            fprintf(stderr, "Error creando procesos: solo se pudieron crear %d de %d (limite de procesos del usuario?)\n",
+                    estadisticas.miembros, argumentos.n_procesos);
+        } else {
+            fprintf(stderr, "Error creando procesos\n");
+        }
+        anillo_destruir(anillo);
+        exit(1);
     }
 
-    // Creacion de lista donde se guardan los PID's
-    pids = malloc(sizeof(pid_t) * n_procesos);
-    padre_pid = getpid();
-    srand(time(NULL));
-
-    // Configuracion de señales para el padre
-    struct sigaction sa_negativo;
-    sa_negativo.sa_flags = SA_SIGINFO;
-    sa_negativo.sa_sigaction = padre_maneja_token_negativo;
-    sigemptyset(&sa_negativo.sa_mask);
-    sigaction(SIGUSR2, &sa_negativo, NULL);
-
-    for (int i = 0; i < n_procesos; i++) {
-        pid_t pid = fork();
-        if (pid == 0) {
-            mi_pid = getpid();
-
-            //Configuracion de señales para los hijos, via para mandar PID's
-            struct sigaction sa1, sa2;
-            sa1.sa_flags = SA_SIGINFO;
-            sa1.sa_sigaction = recibir_siguiente;
-            sigemptyset(&sa1.sa_mask);
-            sigaction(SIGUSR1, &sa1, NULL);
-
-            // Configuracion de señales para los hijos, via para mandar el token
-            sa2.sa_flags = SA_SIGINFO;
-            sa2.sa_sigaction = manejar_token;
-            sigemptyset(&sa2.sa_mask);
-            sigaction(SIGUSR2, &sa2, NULL);
-
-            // Se entra los hijos en un While que nunca acabara para que siempre puedan recibir señales (Se termina en los manejadores)
-            pause();
-            while (1) pause();
-        } else if (pid > 0) {
-            pids[i] = pid;
+    if (argumentos.metricas) {
+        anillo_estadisticas(anillo, &estadisticas);
+        printf("Creacion: %d hijos en %.3f ms (%.1f us por hijo)\n", estadisticas.miembros,
+               estadisticas.ns_creacion / 1e6, estadisticas.ns_creacion / 1e3 / estadisticas.miembros);
+        if (estadisticas.pss_kb >= 0) {
+            printf("PSS: %ld kB todo el anillo, %.1f kB por hijo\n", estadisticas.pss_kb,
+                   (double)estadisticas.pss_kb / estadisticas.miembros);
         } else {
-            perror("Error creando procesos");
-            exit(1);
+            printf("PSS: no disponible (falta /proc/<pid>/smaps_rollup)\n");
         }
+        fflush(stdout);
     }
 
-    // Se duerme el padre para asegurar que esten todos los hijos y despues se manda los PIDs del siguiente creando el anillo
-    sleep(1);
-    for (int i = 0; i < n_procesos; i++) {
-        pid_t siguiente = pids[(i + 1) % n_procesos];
-        sigqueue(pids[i], SIGUSR1, (union sigval){ .sival_int = siguiente });
+    for (int i = 0; i < anillo_miembros(anillo); i++) {
+        reportar(&argumentos, "miembro", anillo_miembro(anillo, i), ahora_ns(), 0, 0);
     }
+    reportar(&argumentos, "inicio", getpid(), ahora_ns(), 0, 0);
 
-    // El padre pasa el primer token de todos y da inicio al desafio
-    sleep(1);
-    sigqueue(pids[0], SIGUSR2, (union sigval){ .sival_int = token_inicial });
+    // El padre pasa los primeros tokens y da inicio al desafio
+    for (int id = 0; id < argumentos.tokens; id++) {
+        reinyectar(anillo, id, &argumentos);
+    }
 
-    // Se queda en un while que nunca termina para poder manejar a los hijos que se vayan elimiando
-    while (1) pause();
+    // Cada eliminacion repara el anillo y el token que elimino empieza una ronda nueva con el valor original, hasta que queda uno
+    const char *nombres[] = {
+        [EVENTO_ELIMINADO] = "eliminado", [EVENTO_CAIDO] = "caido", [EVENTO_REPARADO] = "reparado",
+        [EVENTO_DETENIDO] = "detenido", [EVENTO_CONTINUADO] = "continuado", [EVENTO_REANUDADO] = "reanudado",
+        [EVENTO_RECHAZO] = "rechazo", [EVENTO_RETIRADO] = "retirado",
+    };
+    while (anillo_esperar(anillo, &evento) == 0) {
+        reportar(&argumentos, nombres[evento.tipo], evento.pid, evento.ns, evento.id, evento.ronda);
+
+        // Un hijo que sigue tras SIGCONT responde el sondeo cuando termino con lo que se le acumulo
+        if (evento.tipo == EVENTO_CONTINUADO) anillo_sondear(anillo, evento.pid, 0);
+        if (evento.tipo != EVENTO_ELIMINADO && evento.tipo != EVENTO_CAIDO) continue;
+
+        if (!argumentos.silencioso) {
+            printf(evento.tipo == EVENTO_CAIDO ? "(Proceso %d termino sin ser eliminado)" : "(Proceso %d es eliminado)", evento.pid);
+            fflush(stdout);
+        }
+
+        if (anillo_eliminar(anillo, evento.pid) == 1) {
+            // El ganador se anuncia siempre, incluso en modo silencioso
+            printf("\nProceso %d es el ganador\n", anillo_miembro(anillo, 0));
+            hay_ganador = 1;
+            break;
+        }
+
+        if (evento.tipo == EVENTO_CAIDO) {
+            // No se sabe que tokens tenia el caido: se lanzan todos otra vez y la biblioteca retira las copias viejas.
+            // El sondeo va detras del token 0, asi su respuesta marca que los tokens volvieron a circular
+            for (int id = 0; id < argumentos.tokens; id++) {
+                reinyectar(anillo, id, &argumentos);
+            }
+            anillo_sondear(anillo, anillo_miembro(anillo, posicion_de_partida(anillo, 0, argumentos.tokens)), 0);
+        } else {
+            reinyectar(anillo, evento.id, &argumentos);
+        }
+    }
+
+    // anillo_esperar solo falla si el anillo ya no puede avanzar (por ejemplo sin lugar para enviar mensajes)
+    if (!hay_ganador) {
+        printf("\nError: El anillo dejo de responder antes de que hubiera un ganador.\n");
+        anillo_destruir(anillo);
+        exit(1);
+    }
+
+    if (argumentos.metricas) {
+        anillo_estadisticas(anillo, &estadisticas);
+        printf("Juego: %d eliminaciones en %.3f ms (%.1f por segundo, %d tokens, %d huerfanos, transporte %s)\n",
+               estadisticas.eliminados, estadisticas.ns_transcurridos / 1e6,
+               estadisticas.eliminados / (estadisticas.ns_transcurridos / 1e9), argumentos.tokens,
+               estadisticas.huerfanos, argumentos.transporte->nombre);
+    }
 
-    for (int i = 0; i < n_procesos; i++) {
-        wait(NULL);
+    if (argumentos.reporte) {
+        anillo_estadisticas(anillo, &estadisticas);
+        reportar_estadisticas(&argumentos, &estadisticas);
     }
 
-    free(pids);
+    anillo_destruir(anillo);
     return 0;
 }
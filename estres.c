@@ -0,0 +1,631 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <poll.h>
+#include <time.h>
+#include <grp.h>
+#include <libgen.h>
+#include <glob.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "tokenring.h"
+
+/*
+ * Autores: Omar Elias Saez Arias y Enzo Ivo San Martin Pavez
+ * Proyecto: Laboratorio de procesos en anillo - Arnes de estres con inyeccion de fallas
+ *
+ * Corre desafio1 con anillos de distintos tamaños y, con el juego en marcha, le inyecta una falla:
+ *
+ *   sigkill     SIGKILL a un participante al azar
+ *   sigstop     SIGSTOP a un participante y SIGCONT despues de una demora (-d)
+ *   tormenta    rafaga de mensajes falsos y SIGCHLD hacia el padre
+ *   sigpending  SIGKILL a un participante con RLIMIT_SIGPENDING muy bajo (-i)
+ *   nproc       anillo pedido con RLIMIT_NPROC a la mitad de -p: desafio1 no puede crearlo y tiene que
+ *               fallar al arrancar, sin jugar con menos miembros
+ *
+ * desafio1 se corre con -R, que imprime cada evento del anillo con su instante de CLOCK_MONOTONIC
+ * (el mismo reloj que usa el arnes), asi los tiempos se miden desde que se inyecto la falla:
+ *
+ *   deteccion   hasta que el padre se entero (caido, detenido o primer mensaje rechazado)
+ *   reparacion  hasta que el anterior del caido confirmo su nuevo siguiente (con sigstop, desde el
+ *               SIGCONT hasta que el padre vio al hijo continuar)
+ *   reanudacion hasta que los tokens volvieron a circular: el padre sondea al participante que
+ *               recibe el token 0 reinyectado, o al que continuo, y mide cuando responde. En la
+ *               tormenta es la primera eliminacion despues de la rafaga
+ *
+ * Cada corrida tiene que terminar con un solo ganador valido (un miembro de un anillo con los -p
+ * pedidos, que no fue eliminado ni matado, con p-1 bajas y sin procesos ni FIFOs sobrantes), y ninguna
+ * baja puede venir de una copia vieja de un token: desafio1 informa cada inyeccion y la ronda de cada
+ * eliminacion, asi el arnes sabe cual es la copia vigente de cada token sin preguntarle a la
+ * biblioteca. Los resultados salen
+ * en CSV, una fila por corrida con la version de desafio1 (la informa el mismo, asi es la del binario
+ * medido aunque este arnes sea de otra compilacion), para comparar la recuperacion entre versiones.
+ * En la falla nproc la corrida es valida si desafio1 termina con error sin haber jugado, informando
+ * menos miembros que los pedidos y sin dejar FIFOs.
+ *
+ * La falla sigpending no se corre con el transporte fifo: no encola señales, asi que el limite no
+ * cambia nada y seria otra corrida de sigkill.
+ *
+ * RLIMIT_NPROC no se aplica a root: corriendo como root, el desafio1 de la falla nproc se ejecuta
+ * como "nobody" (por eso se abre antes y se ejecuta con fexecve).
+ */
+
+#define ESPERA_FASE_MS 2000       // maximo para ver cada evento esperado
+#define ESPERA_TOTAL_MS 60000     // maximo para que termine una corrida
+#define USUARIO_SIN_PRIVILEGIOS 65534
+
+typedef enum { FALLA_SIGKILL, FALLA_SIGSTOP, FALLA_TORMENTA, FALLA_SIGPENDING, FALLA_NPROC, N_FALLAS } falla_t;
+static const char *nombres_fallas[N_FALLAS] = { "sigkill", "sigstop", "tormenta", "sigpending", "nproc" };
+
+// Eventos de desafio1 -R que se miden
+typedef enum { EV_ELIMINADO, EV_CAIDO, EV_REPARADO, EV_DETENIDO, EV_CONTINUADO, EV_REANUDADO, EV_RECHAZO, N_EVENTOS } evento_t;
+static const char *nombres_eventos[N_EVENTOS] = { "eliminado", "caido", "reparado", "detenido", "continuado", "reanudado", "rechazo" };
+
+typedef struct {
+    int procesos[16];
+    int n_tamanos;
+    int tokens, max_decremento, token_inicial;
+    int repeticiones;
+    int fallas[N_FALLAS];         // 1 si la falla esta elegida
+    const char *transporte;
+    const char *lanzador;
+    int demora_ms;                // entre SIGSTOP y SIGCONT
+    int senales_tormenta;
+    int limite_sigpending;
+    int ejecutable;               // descriptor de desafio1 para fexecve
+} configuracion_t;
+
+typedef struct {
+    pid_t desafio;                // padre del anillo
+    int fd;                       // salida de desafio1
+    char buffer[16384];
+    size_t largo;
+    int terminado;                // desafio1 cerro su salida
+    char version[64];             // version que informo desafio1
+
+    pid_t *miembros;
+    char *fuera;                  // 1 si ya fue eliminado o cayo
+    int n_miembros;
+    int iniciado;
+    pid_t ganador;
+    int ganadores;
+    int estadisticas[7];          // miembros, eliminados, caidos, huerfanos, obsoletos, rechazados, fallos_lanzamiento
+    int hay_estadisticas;
+    int ronda;                    // inyecciones vistas: anillo_pasar_token numera las rondas desde 1
+    int rondas[ANILLO_MAX_TOKENS + 1];   // ronda de la copia vigente de cada token
+    int eliminados_obsoletos;     // bajas causadas por una copia que ya habia sido reemplazada
+
+    long long desde[N_EVENTOS];   // solo cuentan los eventos desde este instante (0 = no se miden)
+    pid_t filtro[N_EVENTOS];      // y de este PID (0 = cualquiera)
+    long long visto[N_EVENTOS];   // instante del primero que cumplio, 0 si ninguno
+} corrida_t;
+
+// Entradas: ninguna
+// Salidas: instante actual de CLOCK_MONOTONIC en nanosegundos
+// Descripción: Mismo reloj que usa desafio1 -R
+static long long ahora_ns() {
+    struct timespec ahora;
+    clock_gettime(CLOCK_MONOTONIC, &ahora);
+    return ahora.tv_sec * 1000000000LL + ahora.tv_nsec;
+}
+
+// Entradas: corrida y PID
+// Salidas: posicion del miembro, -1 si no es del anillo
+// Descripción: Busqueda lineal entre los miembros informados por desafio1
+static int indice_miembro(const corrida_t *corrida, pid_t pid) {
+    for (int i = 0; i < corrida->n_miembros; i++) {
+        if (corrida->miembros[i] == pid) return i;
+    }
+    return -1;
+}
+
+// Entradas: corrida y una linea completa de la salida de desafio1
+// Salidas: ninguna
+// Descripción: Actualiza los miembros, el ganador, las estadisticas y los instantes de los eventos medidos
+static void procesar_linea(corrida_t *corrida, const char *linea) {
+    char nombre[32];
+    int pid, id = 0, ronda = 0;
+    long long ns;
+
+    if (sscanf(linea, "Proceso %d es el ganador", &pid) == 1) {
+        corrida->ganador = pid;
+        corrida->ganadores++;
+        return;
+    }
+    if (sscanf(linea, "version,%63s", corrida->version) == 1) return;
+    if (strncmp(linea, "estadisticas,", 13) == 0) {
+        int *e = corrida->estadisticas;
+        corrida->hay_estadisticas = sscanf(linea + 13, "%d,%d,%d,%d,%d,%d,%d", &e[0], &e[1], &e[2], &e[3], &e[4], &e[5], &e[6]) == 7;
+        return;
+    }
+    if (sscanf(linea, "evento,%31[^,],%d,%lld,%d,%d", nombre, &pid, &ns, &id, &ronda) < 3) return;
+    id &= ANILLO_MAX_TOKENS;
+
+    if (strcmp(nombre, "miembro") == 0) {
+        corrida->miembros = realloc(corrida->miembros, sizeof(pid_t) * (corrida->n_miembros + 1));
+        corrida->fuera = realloc(corrida->fuera, corrida->n_miembros + 1);
+        corrida->miembros[corrida->n_miembros] = pid;
+        corrida->fuera[corrida->n_miembros++] = 0;
+        return;
+    }
+    if (strcmp(nombre, "inicio") == 0) {
+        corrida->iniciado = 1;
+        return;
+    }
+    if (strcmp(nombre, "inyectado") == 0) {
+        corrida->rondas[id] = ++corrida->ronda;
+        return;
+    }
+    // Con el transporte de señales la ronda viaja en 16 bits
+    if (strcmp(nombre, "eliminado") == 0 && ((ronda ^ corrida->rondas[id]) & 0xffff) != 0) {
+        corrida->eliminados_obsoletos++;
+    }
+
+    for (int e = 0; e < N_EVENTOS; e++) {
+        if (strcmp(nombre, nombres_eventos[e]) != 0) continue;
+
+        if (e == EV_ELIMINADO || e == EV_CAIDO) {
+            int indice = indice_miembro(corrida, pid);
+            if (indice != -1) corrida->fuera[indice] = 1;
+        }
+        if (corrida->desde[e] != 0 && corrida->visto[e] == 0 && ns >= corrida->desde[e] &&
+            (corrida->filtro[e] == 0 || corrida->filtro[e] == pid)) {
+            corrida->visto[e] = ns;
+        }
+    }
+}
+
+// Entradas: corrida, mascara de eventos (1 << evento_t) a esperar e instante limite
+// Salidas: 1 si se vieron todos, 0 si no (se acabo el tiempo o termino el juego)
+// Descripción: Lee la salida de desafio1 linea por linea hasta ver los eventos pedidos. Con mascara 0 solo lee hasta el limite
+static int esperar(corrida_t *corrida, int mascara, long long limite) {
+    while (1) {
+        // Primero se consumen las lineas completas que ya estan en el buffer, de a una
+        char *fin;
+        while ((fin = memchr(corrida->buffer, '\n', corrida->largo)) != NULL) {
+            *fin = '\0';
+            procesar_linea(corrida, corrida->buffer);
+            size_t consumido = fin - corrida->buffer + 1;
+            memmove(corrida->buffer, fin + 1, corrida->largo - consumido);
+            corrida->largo -= consumido;
+
+            int faltan = 0;
+            for (int e = 0; e < N_EVENTOS; e++) {
+                if ((mascara & (1 << e)) && corrida->visto[e] == 0) faltan = 1;
+            }
+            if (mascara != 0 && !faltan) return 1;
+            if (mascara != 0 && corrida->ganadores > 0) return 0;
+        }
+        if (corrida->terminado) return 0;
+
+        long long restante = (limite - ahora_ns()) / 1000000;
+        if (restante <= 0) return 0;
+
+        struct pollfd espera = { .fd = corrida->fd, .events = POLLIN };
+        int listos = poll(&espera, 1, (int)restante);
+        if (listos == -1 && errno == EINTR) continue;
+        if (listos <= 0) return 0;
+
+        // Si el buffer esta lleno sin ningun fin de linea, la linea no es del formato: se descarta
+        if (corrida->largo == sizeof(corrida->buffer)) corrida->largo = 0;
+        ssize_t leido = read(corrida->fd, corrida->buffer + corrida->largo, sizeof(corrida->buffer) - corrida->largo);
+        if (leido <= 0) {
+            corrida->terminado = 1;
+        } else {
+            corrida->largo += leido;
+        }
+    }
+}
+
+// Entradas: corrida, evento, instante desde el que cuenta y PID que debe tener (0 = cualquiera)
+// Salidas: ninguna
+// Descripción: Empieza a medir un evento
+static void medir(corrida_t *corrida, evento_t evento, long long desde, pid_t filtro) {
+    corrida->desde[evento] = desde;
+    corrida->filtro[evento] = filtro;
+    corrida->visto[evento] = 0;
+}
+
+// Entradas: uid
+// Salidas: cantidad de hilos de ese usuario
+// Descripción: Recorre /proc. RLIMIT_NPROC se compara contra todos los hilos del usuario, no solo los hijos
+static int contar_hilos(uid_t uid) {
+    DIR *proc = opendir("/proc");
+    struct dirent *entrada;
+    int cantidad = 0;
+
+    if (proc == NULL) return 0;
+    while ((entrada = readdir(proc)) != NULL) {
+        char ruta[300], linea[128];
+        unsigned int real = 0;
+        int hilos;
+        if (entrada->d_name[0] < '0' || entrada->d_name[0] > '9') continue;
+
+        snprintf(ruta, sizeof(ruta), "/proc/%s/status", entrada->d_name);
+        FILE *estado = fopen(ruta, "r");
+        if (estado == NULL) continue;
+        // "Uid:" aparece antes que "Threads:"
+        while (fgets(linea, sizeof(linea), estado) != NULL) {
+            sscanf(linea, "Uid: %u", &real);
+            if (sscanf(linea, "Threads: %d", &hilos) == 1) {
+                if (real == uid) cantidad += hilos;
+                break;
+            }
+        }
+        fclose(estado);
+    }
+    closedir(proc);
+    return cantidad;
+}
+
+// Entradas: configuracion, falla, tamaño del anillo y corrida a completar
+// Salidas: 0 si desafio1 quedo corriendo, -1 si no
+// Descripción: Lanza desafio1 -s -R con la salida en un pipe, aplicando antes los limites de la falla
+static int lanzar_desafio(const configuracion_t *configuracion, falla_t falla, int procesos, corrida_t *corrida) {
+    int tuberia[2];
+    char p[16], M[16], t[16], k[16];
+
+    snprintf(p, sizeof(p), "%d", procesos);
+    snprintf(M, sizeof(M), "%d", configuracion->max_decremento);
+    snprintf(t, sizeof(t), "%d", configuracion->token_inicial);
+    snprintf(k, sizeof(k), "%d", configuracion->tokens);
+    char *argumentos[] = { "desafio1", "-p", p, "-M", M, "-t", t, "-k", k, "-s", "-R",
+                           "-T", (char *)configuracion->transporte, "-L", (char *)configuracion->lanzador, NULL };
+
+    // El limite de procesos se calcula antes del fork, sobre el usuario que va a correr desafio1
+    rlim_t limite_procesos = 0;
+    if (falla == FALLA_NPROC) {
+        limite_procesos = contar_hilos(geteuid() == 0 ? USUARIO_SIN_PRIVILEGIOS : geteuid()) + procesos / 2;
+    }
+
+    if (pipe(tuberia) == -1) return -1;
+    pid_t pid = fork();
+    if (pid == -1) return -1;
+
+    if (pid == 0) {
+        dup2(tuberia[1], STDOUT_FILENO);
+        close(tuberia[0]);
+        close(tuberia[1]);
+
+        if (falla == FALLA_SIGPENDING) {
+            struct rlimit limite = { configuracion->limite_sigpending, configuracion->limite_sigpending };
+            setrlimit(RLIMIT_SIGPENDING, &limite);
+        } else if (falla == FALLA_NPROC) {
+            struct rlimit limite = { limite_procesos, limite_procesos };
+            setrlimit(RLIMIT_NPROC, &limite);
+            if (geteuid() == 0 && (setgroups(0, NULL) == -1 || setgid(USUARIO_SIN_PRIVILEGIOS) == -1 ||
+                                   setuid(USUARIO_SIN_PRIVILEGIOS) == -1)) {
+                _exit(126);
+            }
+        }
+        fexecve(configuracion->ejecutable, argumentos, environ);
+        _exit(127);
+    }
+
+    close(tuberia[1]);
+    corrida->desafio = pid;
+    corrida->fd = tuberia[0];
+    return 0;
+}
+
+// Entradas: corrida
+// Salidas: PID de un miembro al azar que sigue en el anillo, -1 si no hay
+// Descripción: Elige el objetivo de la falla
+static pid_t miembro_al_azar(const corrida_t *corrida) {
+    int vivos = 0;
+    for (int i = 0; i < corrida->n_miembros; i++) vivos += !corrida->fuera[i];
+    if (vivos == 0) return -1;
+
+    int elegido = rand() % vivos;
+    for (int i = 0; i < corrida->n_miembros; i++) {
+        if (!corrida->fuera[i] && elegido-- == 0) return corrida->miembros[i];
+    }
+    return -1;
+}
+
+// Entradas: PID del padre del anillo, buffer y su tamaño
+// Salidas: 1 si existe el directorio de FIFOs del anillo (queda en ruta), 0 si no
+// Descripción: Busca el directorio privado que crea el transporte fifo (/tmp/tokenring-<padre>-XXXXXX)
+static int directorio_fifos(pid_t padre, char *ruta, size_t largo) {
+    char patron[64];
+    glob_t encontrados;
+    int hay = 0;
+
+    snprintf(patron, sizeof(patron), "/tmp/tokenring-%d-*", padre);
+    if (glob(patron, GLOB_NOSORT, NULL, &encontrados) == 0) {
+        hay = 1;
+        if (ruta != NULL) snprintf(ruta, largo, "%s", encontrados.gl_pathv[0]);
+    }
+    globfree(&encontrados);
+    return hay;
+}
+
+// Entradas: configuracion y PID del padre del anillo
+// Salidas: ninguna
+// Descripción: Rafaga hacia el padre: la mitad SIGCHLD sin ningun hijo que recoger y la otra mitad mensajes
+// falsos por el transporte en uso (sigqueue de SIGRTMIN, o escritos en su FIFO) que dicen venir de un eliminado
+static void tormenta(const configuracion_t *configuracion, pid_t padre) {
+    int fifo = -1;
+    char directorio[64], ruta[96];
+    if (strcmp(configuracion->transporte, "fifo") == 0 && directorio_fifos(padre, directorio, sizeof(directorio))) {
+        snprintf(ruta, sizeof(ruta), "%s/%d", directorio, padre);
+        fifo = open(ruta, O_WRONLY | O_NONBLOCK | O_NOFOLLOW);
+    }
+
+    for (int i = 0; i < configuracion->senales_tormenta; i++) {
+        if (i % 2 == 0) {
+            kill(padre, SIGCHLD);
+        } else if (fifo != -1) {
+            mensaje_t falso = { .tipo = MENSAJE_ELIMINADO, .origen = getpid(), .valor = -1, .ronda = i };
+            write(fifo, &falso, sizeof(falso));
+        } else {
+            sigqueue(padre, SIGRTMIN, (union sigval){ .sival_int = -1 });
+        }
+    }
+    if (fifo != -1) close(fifo);
+}
+
+// Entradas: corrida, transporte, falla, tamaño pedido, participante matado por la falla (0 si ninguno) y estado de salida de desafio1
+// Salidas: 1 si el juego termino bien
+// Descripción: Un anillo de "procesos" miembros con un solo ganador que es miembro, no fue eliminado ni matado, p-1 bajas (ninguna por una copia vieja de un token) y nada sobrante. Con nproc, un arranque fallido y limpio
+static int ganador_valido(const corrida_t *corrida, const char *transporte, falla_t falla, int procesos, pid_t matado, int estado) {
+    int sobran_fifos = strcmp(transporte, "fifo") == 0 && directorio_fifos(corrida->desafio, NULL, 0);
+
+    if (falla == FALLA_NPROC) {
+        return WIFEXITED(estado) && WEXITSTATUS(estado) == 1 && corrida->ganadores == 0 && corrida->n_miembros == 0 &&
+               corrida->hay_estadisticas && corrida->estadisticas[0] < procesos && corrida->estadisticas[6] > 0 &&
+               !sobran_fifos;
+    }
+
+    if (!WIFEXITED(estado) || WEXITSTATUS(estado) != 0) return 0;
+    if (corrida->ganadores != 1 || !corrida->hay_estadisticas) return 0;
+    if (corrida->eliminados_obsoletos > 0) return 0;
+
+    int indice = indice_miembro(corrida, corrida->ganador);
+    if (indice == -1 || corrida->fuera[indice] || corrida->ganador == matado) return 0;
+    if (corrida->n_miembros != procesos || corrida->estadisticas[0] != procesos) return 0;
+    if (corrida->estadisticas[1] + corrida->estadisticas[2] != procesos - 1) return 0;
+
+    for (int i = 0; i < corrida->n_miembros; i++) {
+        if (kill(corrida->miembros[i], 0) == 0 || errno != ESRCH) return 0;
+    }
+    // El directorio del anillo solo se borra cuando ya no queda ninguna FIFO adentro
+    return !sobran_fifos;
+}
+
+// Entradas: salida CSV, nanosegundos de una medicion (0 = no se vio) y origen
+// Salidas: ninguna
+// Descripción: Escribe la diferencia en microsegundos, o el campo vacio
+static void escribir_us(FILE *salida, long long visto, long long desde) {
+    if (visto == 0 || desde == 0) {
+        fprintf(salida, ",");
+    } else {
+        fprintf(salida, ",%.1f", (visto - desde) / 1e3);
+    }
+}
+
+// Entradas: configuracion, falla, tamaño, numero de repeticion y salida CSV
+// Salidas: 1 si el juego termino con un ganador valido
+// Descripción: Una corrida completa: lanzar, esperar que el anillo trabaje, inyectar la falla, medir y validar
+static int correr(const configuracion_t *configuracion, falla_t falla, int procesos, int repeticion, FILE *salida) {
+    corrida_t corrida = { .desafio = -1, .fd = -1, .version = "desconocida" };
+    long long desde_deteccion = 0, desde_reparacion = 0, desde_reanudacion = 0;
+    pid_t objetivo = 0, matado = 0;
+    int estado = 0;
+
+    long long lanzado = ahora_ns();
+    if (lanzar_desafio(configuracion, falla, procesos, &corrida) != 0) {
+        perror("estres: no se pudo lanzar desafio1");
+        return 0;
+    }
+
+    // Con el anillo armado se espera la primera eliminacion para inyectar la falla con los tokens en vuelo
+    medir(&corrida, EV_ELIMINADO, lanzado, 0);
+    esperar(&corrida, 1 << EV_ELIMINADO, ahora_ns() + ESPERA_TOTAL_MS * 1000000LL);
+
+    if (corrida.ganadores == 0 && !corrida.terminado && (objetivo = miembro_al_azar(&corrida)) > 0) {
+        long long inyectada = ahora_ns();
+        long long limite = inyectada + ESPERA_FASE_MS * 1000000LL;
+
+        if (falla == FALLA_SIGSTOP) {
+            medir(&corrida, EV_DETENIDO, inyectada, objetivo);
+            kill(objetivo, SIGSTOP);
+            esperar(&corrida, 1 << EV_DETENIDO, limite);
+            esperar(&corrida, 0, inyectada + configuracion->demora_ms * 1000000LL);
+
+            long long continuado = ahora_ns();
+            medir(&corrida, EV_CONTINUADO, continuado, objetivo);
+            medir(&corrida, EV_REANUDADO, continuado, objetivo);
+            kill(objetivo, SIGCONT);
+            esperar(&corrida, (1 << EV_CONTINUADO) | (1 << EV_REANUDADO), continuado + ESPERA_FASE_MS * 1000000LL);
+
+            desde_deteccion = inyectada;
+            desde_reparacion = desde_reanudacion = continuado;
+        } else if (falla == FALLA_TORMENTA) {
+            medir(&corrida, EV_RECHAZO, inyectada, 0);
+            tormenta(configuracion, corrida.desafio);
+            long long fin_tormenta = ahora_ns();
+            medir(&corrida, EV_ELIMINADO, fin_tormenta, 0);
+            esperar(&corrida, (1 << EV_RECHAZO) | (1 << EV_ELIMINADO), fin_tormenta + ESPERA_FASE_MS * 1000000LL);
+
+            desde_deteccion = inyectada;
+            desde_reanudacion = fin_tormenta;
+        } else {
+            medir(&corrida, EV_CAIDO, inyectada, objetivo);
+            medir(&corrida, EV_REPARADO, inyectada, objetivo);
+            medir(&corrida, EV_REANUDADO, inyectada, 0);
+            kill(objetivo, SIGKILL);
+            matado = objetivo;
+            esperar(&corrida, (1 << EV_CAIDO) | (1 << EV_REPARADO) | (1 << EV_REANUDADO), limite);
+
+            desde_deteccion = desde_reparacion = desde_reanudacion = inyectada;
+        }
+    }
+
+    // El resto del juego hasta el ganador. Si se cuelga se mata y la corrida queda invalida
+    while (!corrida.terminado && esperar(&corrida, 0, lanzado + ESPERA_TOTAL_MS * 1000000LL) == 0 &&
+           ahora_ns() < lanzado + ESPERA_TOTAL_MS * 1000000LL);
+    if (!corrida.terminado) kill(corrida.desafio, SIGKILL);
+    while (waitpid(corrida.desafio, &estado, 0) == -1 && errno == EINTR);
+    long long duracion = ahora_ns() - lanzado;
+    close(corrida.fd);
+
+    int valido = ganador_valido(&corrida, configuracion->transporte, falla, procesos, matado, estado);
+    long long reanudado = falla == FALLA_TORMENTA ? corrida.visto[EV_ELIMINADO] : corrida.visto[EV_REANUDADO];
+    long long detectado = falla == FALLA_SIGSTOP ? corrida.visto[EV_DETENIDO]
+                        : falla == FALLA_TORMENTA ? corrida.visto[EV_RECHAZO] : corrida.visto[EV_CAIDO];
+    long long reparado = falla == FALLA_SIGSTOP ? corrida.visto[EV_CONTINUADO] : corrida.visto[EV_REPARADO];
+
+    fprintf(salida, "%s,%ld,%s,%s,%d,%d,%s,%d,%d", corrida.version, (long)time(NULL), configuracion->transporte,
+            configuracion->lanzador, procesos, configuracion->tokens, nombres_fallas[falla], repeticion, objetivo);
+    escribir_us(salida, detectado, desde_deteccion);
+    escribir_us(salida, reparado, falla == FALLA_TORMENTA ? 0 : desde_reparacion);
+    escribir_us(salida, reanudado, desde_reanudacion);
+    fprintf(salida, ",%.3f,%d,%d,%d,%d,%d,%d\n", duracion / 1e6, corrida.estadisticas[0], corrida.estadisticas[1],
+            corrida.estadisticas[2], corrida.estadisticas[5], corrida.ganador, valido);
+    fflush(salida);
+
+    free(corrida.miembros);
+    free(corrida.fuera);
+    return valido;
+}
+
+// Entradas: ninguna
+// Salidas: ninguna
+// Descripción: Muestra el uso y termina
+static void mostrar_uso() {
+    printf("Uso: ./estres [-p 10,100,500] [-f sigkill,sigstop,tormenta,sigpending,nproc] [-r repeticiones]\n");
+    printf("              [-k tokens] [-M max_decremento] [-t token_inicial] [-T senales|fifo] [-L clone|fork]\n");
+    printf("              [-d demora_ms] [-n senales_tormenta] [-i limite_sigpending] [-o archivo.csv] [-x desafio1]\n");
+    printf("Ejemplo: ./estres -p 10,200 -f sigkill,sigstop -r 5 -o recuperacion.csv\n");
+    printf("  Con -o las filas se agregan al archivo (el encabezado solo si esta vacio); si no, van a la salida estandar\n");
+    exit(1);
+}
+
+// Entradas: argumentos de la linea de comandos (ver mostrar_uso)
+// Salidas: 0 si todas las corridas terminaron con un ganador valido, 1 si no
+// Descripción: Recorre tamaños, fallas y repeticiones y escribe el CSV
+int main(int argc, char *argv[]) {
+    configuracion_t configuracion = {
+        .procesos = { 10, 100, 500 }, .n_tamanos = 3,
+        .tokens = 1, .max_decremento = 10, .token_inicial = 1000, .repeticiones = 3,
+        .fallas = { 1, 1, 1, 1, 1 },
+        .transporte = "senales", .lanzador = "clone",
+        .demora_ms = 20, .senales_tormenta = 2000, .limite_sigpending = 4,
+    };
+    const char *archivo = NULL;
+    char ruta_desafio[4096];
+
+    // Por defecto desafio1 esta junto a este ejecutable
+    ssize_t largo = readlink("/proc/self/exe", ruta_desafio, sizeof(ruta_desafio) - 16);
+    if (largo <= 0) largo = snprintf(ruta_desafio, sizeof(ruta_desafio), "./estres");
+    ruta_desafio[largo] = '\0';
+    strcat(dirname(ruta_desafio), "/desafio1");
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) mostrar_uso();
+        char *valor = argv[++i];
+
+        if (strcmp(argv[i - 1], "-p") == 0) {
+            configuracion.n_tamanos = 0;
+            for (char *parte = strtok(valor, ","); parte != NULL && configuracion.n_tamanos < 16; parte = strtok(NULL, ",")) {
+                configuracion.procesos[configuracion.n_tamanos] = atoi(parte);
+                if (configuracion.procesos[configuracion.n_tamanos++] <= 1) mostrar_uso();
+            }
+        } else if (strcmp(argv[i - 1], "-f") == 0) {
+            memset(configuracion.fallas, 0, sizeof(configuracion.fallas));
+            for (char *parte = strtok(valor, ","); parte != NULL; parte = strtok(NULL, ",")) {
+                int f = 0;
+                while (f < N_FALLAS && strcmp(parte, nombres_fallas[f]) != 0) f++;
+                if (f == N_FALLAS) mostrar_uso();
+                configuracion.fallas[f] = 1;
+            }
+        } else if (strcmp(argv[i - 1], "-r") == 0) {
+            configuracion.repeticiones = atoi(valor);
+        } else if (strcmp(argv[i - 1], "-k") == 0) {
+            configuracion.tokens = atoi(valor);
+        } else if (strcmp(argv[i - 1], "-M") == 0) {
+            configuracion.max_decremento = atoi(valor);
+        } else if (strcmp(argv[i - 1], "-t") == 0) {
+            configuracion.token_inicial = atoi(valor);
+        } else if (strcmp(argv[i - 1], "-T") == 0) {
+            configuracion.transporte = valor;
+        } else if (strcmp(argv[i - 1], "-L") == 0) {
+            configuracion.lanzador = valor;
+        } else if (strcmp(argv[i - 1], "-d") == 0) {
+            configuracion.demora_ms = atoi(valor);
+        } else if (strcmp(argv[i - 1], "-n") == 0) {
+            configuracion.senales_tormenta = atoi(valor);
+        } else if (strcmp(argv[i - 1], "-i") == 0) {
+            configuracion.limite_sigpending = atoi(valor);
+        } else if (strcmp(argv[i - 1], "-o") == 0) {
+            archivo = valor;
+        } else if (strcmp(argv[i - 1], "-x") == 0) {
+            snprintf(ruta_desafio, sizeof(ruta_desafio), "%s", valor);
+        } else {
+            mostrar_uso();
+        }
+    }
+    if (configuracion.repeticiones < 1 || configuracion.limite_sigpending < 1 ||
+        transporte_por_nombre(configuracion.transporte) == NULL) {
+        mostrar_uso();
+    }
+    if (configuracion.tokens < 1 || configuracion.tokens > ANILLO_MAX_TOKENS) {
+        fprintf(stderr, "estres: -k debe estar entre 1 y %d\n", ANILLO_MAX_TOKENS);
+        exit(1);
+    }
+    if (strcmp(configuracion.transporte, "fifo") == 0 && configuracion.fallas[FALLA_SIGPENDING]) {
+        configuracion.fallas[FALLA_SIGPENDING] = 0;
+        fprintf(stderr, "estres: la falla sigpending no aplica al transporte fifo (no usa señales), se omite\n");
+
+        int quedan = 0;
+        for (int f = 0; f < N_FALLAS; f++) quedan += configuracion.fallas[f];
+        if (quedan == 0) exit(1);
+    }
+
+    configuracion.ejecutable = open(ruta_desafio, O_RDONLY | O_CLOEXEC);
+    if (configuracion.ejecutable == -1) {
+        perror(ruta_desafio);
+        exit(1);
+    }
+
+    FILE *salida = archivo != NULL ? fopen(archivo, "a") : stdout;
+    if (salida == NULL) {
+        perror(archivo);
+        exit(1);
+    }
+    if (ftell(salida) <= 0) {
+        fprintf(salida, "version,fecha,transporte,lanzador,procesos,tokens,falla,repeticion,objetivo,"
+                        "deteccion_us,reparacion_us,reanudacion_us,duracion_ms,miembros,eliminados,caidos,"
+                        "rechazados,ganador,valido\n");
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    srand(time(NULL) ^ getpid());
+
+    int corridas = 0, invalidas = 0;
+    for (int t = 0; t < configuracion.n_tamanos; t++) {
+        for (int f = 0; f < N_FALLAS; f++) {
+            if (!configuracion.fallas[f]) continue;
+            for (int r = 1; r <= configuracion.repeticiones; r++) {
+                corridas++;
+                if (!correr(&configuracion, f, configuracion.procesos[t], r, salida)) {
+                    invalidas++;
+                    fprintf(stderr, "estres: corrida invalida (-p %d, %s, repeticion %d)\n",
+                            configuracion.procesos[t], nombres_fallas[f], r);
+                }
+            }
+        }
+    }
+
+    fprintf(stderr, "estres: %d corridas, %d invalidas\n", corridas, invalidas);
+    if (archivo != NULL) fclose(salida);
+    return invalidas > 0;
+}
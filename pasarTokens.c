@@ -1,11 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <unistd.h>
-#include <signal.h>
-#include <sys/types.h>
-#include <sys/wait.h>
-#include <string.h>
-#include <time.h>
+
+#include "tokenring.h"
 
 // -- Idea principal: Cada proceso conoce al siguiente en un anillo.
 // Si un proceso muere (token < 0), avisa al padre. El padre actualiza el anillo informando al anterior.
@@ -14,191 +10,93 @@
 /*
  * Proyecto: Laboratorio de procesos en anillo - Simulación de paso de token con señales
  *
- * Descripción general de la idea:
- *
- * 1. El proceso padre comienza creando todos los procesos hijos necesarios y guarda sus PIDs.
- *
- * 2. Una vez que todos los hijos están creados, el padre les envía a cada uno la lista completa
- *    de PIDs. Cada hijo, al recibirla, identifica cuál es su propio PID y así determina quién es
- *    su "siguiente" en el anillo.
- *
- * 3. Solo uno de los procesos recibe inicialmente el "token" (un número entero). Ese token es
- *    pasado de un proceso a otro en forma de señales, simulando el movimiento en anillo.
- *
- * 4. Cada vez que un proceso recibe el token, lo reduce en un número aleatorio. Si el token se
- *    vuelve negativo, ese proceso se "elimina" a sí mismo y avisa al padre que ha muerto.
- *
- * 5. El padre, al ser notificado, actualiza la lista de PIDs eliminando al proceso caído, y
- *    a la vez cual es el proceso antes del eliminado, para enviar el nuevo PID del proceso siguiente
- *    realizando asi la nueva conexion en el anillo.
- *
- * 6. Así, el ciclo continúa con cada ronda pasando el Token original por parte del padre al primero de la lista, 
- *    hasta que queda solamente un proceso activo en el anillo. Ese es el "ganador".
- *
- * 7. El proceso padre permanece vivo durante toda la ejecución, monitoreando todo el sistema y
- *    finaliza solo cuando el declara un ganador.
+ * Version detallada de desafio1: mismo juego sobre libtokenring, pero cada proceso y el padre
+ * cuentan paso a paso lo que hacen.
  *
  * Resultado: Una simulación limpia, controlada y ordenada de un sistema de paso de token entre
  * procesos en anillo, con eliminación progresiva hasta que quede un solo sobreviviente.
  */
 
+// Callback de cada salto: resta un aleatorio al token y cuenta que hara con el
+int manejar_token(anillo_salto_t *salto, void *contexto) {
+    const anillo_argumentos_t *argumentos = contexto;
 
-pid_t next_pid = -1;
-int token = -1;
-int max_decremento = 0;
-pid_t mi_pid;
-pid_t padre_pid;
-int token_inicial = -1;
-
-// Manejador para recibir el PID del siguiente proceso (fase inicial)
-void recibir_siguiente(int sig, siginfo_t *info, void *context) {
-    next_pid = info->si_value.sival_int;
-    printf("[Proceso %d] Nuevo siguiente PID recibido: %d\n", getpid(), next_pid);
-    fflush(stdout);
-}
-
-void manejar_token(int sig, siginfo_t *info, void *context) {
-    token = info->si_value.sival_int;
-
-    printf("\n[Proceso %d] Token recibido: %d\n", getpid(), token);
-    fflush(stdout);
+    anillo_escribir("\n[Proceso %d] Token recibido: %d\n", salto->yo, salto->valor);
 
-    int decremento = rand() % (max_decremento + 1);
-    token -= decremento;
+    int decremento = rand_r(&salto->semilla) % (argumentos->max_decremento + 1);
+    int token = salto->valor - decremento;
 
-    printf("[Proceso %d] Resta %d al token. Token resultante: %d\n", getpid(), decremento, token);
-    fflush(stdout);
+    anillo_escribir("[Proceso %d] Resta %d al token. Token resultante: %d\n", salto->yo, decremento, token);
 
     if (token < 0) {
-        printf("[Proceso %d] Token negativo. Notificando al padre y terminando...\n", getpid());
-        sigqueue(padre_pid, SIGUSR2, (union sigval){ .sival_int = token });
-        exit(0);
+        anillo_escribir("[Proceso %d] Token negativo. Notificando al padre y terminando...\n", salto->yo);
     } else {
-        printf("[Proceso %d] enviara token al proceso %d\n", getpid(), next_pid);
-        fflush(stdout);
-        sigqueue(next_pid, SIGUSR2, (union sigval){ .sival_int = token });
+        anillo_escribir("[Proceso %d] enviara token al proceso %d\n", salto->yo, salto->siguiente);
     }
+    return token;
 }
 
-void padre_maneja_token_negativo(int sig, siginfo_t *info, void *context) {
-    pid_t muerto = info->si_pid;
-    int token_negativo = info->si_value.sival_int;
-
-    printf("\n[Padre] Proceso %d murió con token %d\n", muerto, token_negativo);
-    fflush(stdout);
-
-    extern pid_t *pids;
-    extern int n_procesos;
-
-    int index_muerto = -1;
-    for (int i = 0; i < n_procesos; i++) {
-        if (pids[i] == muerto) {
-            index_muerto = i;
-            break;
-        }
-    }
-    if (index_muerto == -1) return;
-
-    pid_t anterior = pids[(index_muerto - 1 + n_procesos) % n_procesos];
-    pid_t siguiente = pids[(index_muerto + 1) % n_procesos];
-
-    if (anterior == siguiente) {
-        printf("[Padre] Solo queda un proceso vivo. El ganador es %d\n", anterior);
-        fflush(stdout);
-        kill(anterior, SIGTERM);
-        free(pids);
-        exit(0);
-    }
+int main(int argc, char *argv[]) {
+    anillo_argumentos_t argumentos;
+    anillo_evento_t evento;
+    int hay_ganador = 0;
 
-    for (int i = index_muerto; i < n_procesos - 1; i++) {
-        pids[i] = pids[i + 1];
+    if (anillo_leer_argumentos(argc, argv, "pMt", &argumentos) != 0) {
+        printf("Uso: %s -p <n_procesos> -M <max_decremento> -t <token_inicial> [-T senales|fifo] [-L clone|fork]\n", argv[0]);
+        exit(1);
     }
-    n_procesos--;
-
-    printf("[Padre] Actualizando proceso %d con nuevo siguiente %d\n", anterior, siguiente);
-    fflush(stdout);
-    sigqueue(anterior, SIGUSR1, (union sigval){ .sival_int = siguiente });
-    usleep(100000);
-
-    // Reenviar token inicial al primero de la lista
-    printf("[Padre] Reenviando token inicial %d al proceso %d\n", token_inicial, pids[0]);
-    fflush(stdout);
-    sigqueue(pids[0], SIGUSR2, (union sigval){ .sival_int = token_inicial });
-}
-
-pid_t *pids;
-int n_procesos = -1;
 
-int main(int argc, char *argv[]) {
-    for (int i = 0; i < argc; i++) {
-        if (strcmp(argv[i], "-p") == 0) {
-            n_procesos = atoi(argv[i + 1]);
-        } else if (strcmp(argv[i], "-M") == 0) {
-            max_decremento = atoi(argv[i + 1]);
-        } else if (strcmp(argv[i], "-t") == 0) {
-            token_inicial = atoi(argv[i + 1]);
-        }
+    anillo_opciones_t opciones = {
+        .n_procesos = argumentos.n_procesos,
+        .transporte = argumentos.transporte,
+        .lanzador = argumentos.lanzador,
+    };
+    anillo_t *anillo = anillo_crear(&opciones);
+    if (anillo == NULL) {
+        printf("Argumentos inválidos\n");
+        exit(1);
     }
+    anillo_registrar_callback(anillo, manejar_token, &argumentos);
 
-    if (n_procesos <= 0 || max_decremento <= 0) {
-        printf("Argumentos inválidos\n");
+    if (anillo_iniciar(anillo) != 0) {
+        fprintf(stderr, "Error creando procesos\n");
+        anillo_destruir(anillo);
         exit(1);
     }
 
-    pids = malloc(sizeof(pid_t) * n_procesos);
-    padre_pid = getpid();
-    srand(time(NULL));
-
-    struct sigaction sa_negativo;
-    sa_negativo.sa_flags = SA_SIGINFO;
-    sa_negativo.sa_sigaction = padre_maneja_token_negativo;
-    sigemptyset(&sa_negativo.sa_mask);
-    sigaction(SIGUSR2, &sa_negativo, NULL);
-
-    for (int i = 0; i < n_procesos; i++) {
-        pid_t pid = fork();
-        if (pid == 0) {
-            mi_pid = getpid();
-
-            struct sigaction sa1, sa2;
-            sa1.sa_flags = SA_SIGINFO;
-            sa1.sa_sigaction = recibir_siguiente;
-            sigemptyset(&sa1.sa_mask);
-            sigaction(SIGUSR1, &sa1, NULL);
-
-            sa2.sa_flags = SA_SIGINFO;
-            sa2.sa_sigaction = manejar_token;
-            sigemptyset(&sa2.sa_mask);
-            sigaction(SIGUSR2, &sa2, NULL);
-
-            pause();
-            while (1) pause();
-        } else if (pid > 0) {
-            pids[i] = pid;
+    printf("[Padre] Enviando token inicial %d al proceso %d\n", argumentos.token_inicial, anillo_miembro(anillo, 0));
+    fflush(stdout);
+    anillo_pasar_token(anillo, 0, 0, argumentos.token_inicial);
+
+    while (anillo_esperar(anillo, &evento) == 0) {
+        // Un hijo que murio por otra causa se saca igual; con un solo token basta volver a lanzarlo
+        if (evento.tipo == EVENTO_CAIDO) {
+            printf("\n[Padre] Proceso %d terminó sin ser eliminado\n", evento.pid);
+        } else if (evento.tipo == EVENTO_ELIMINADO) {
+            printf("\n[Padre] Proceso %d murió con token %d\n", evento.pid, evento.valor);
         } else {
-            perror("Error creando procesos");
-            exit(1);
+            continue;
         }
-    }
 
-    sleep(1);
-    // Enviar a cada hijo el PID de su siguiente en el anillo
-    for (int i = 0; i < n_procesos; i++) {
-        pid_t siguiente = pids[(i + 1) % n_procesos];
-        sigqueue(pids[i], SIGUSR1, (union sigval){ .sival_int = siguiente });
-    }
-
-    sleep(1);
-    printf("[Padre] Enviando token inicial %d al proceso %d\n", token_inicial, pids[0]);
-    fflush(stdout);
-    sigqueue(pids[0], SIGUSR2, (union sigval){ .sival_int = token_inicial });
+        int indice = anillo_indice(anillo, evento.pid);
+        pid_t anterior = anillo_miembro(anillo, indice - 1);
+        pid_t siguiente = anillo_miembro(anillo, indice + 1);
 
-    while (1) pause();
+        if (anillo_eliminar(anillo, evento.pid) == 1) {
+            printf("[Padre] Solo queda un proceso vivo. El ganador es %d\n", anillo_miembro(anillo, 0));
+            fflush(stdout);
+            hay_ganador = 1;
+            break;
+        }
+        printf("[Padre] Actualizando proceso %d con nuevo siguiente %d\n", anterior, siguiente);
 
-    for (int i = 0; i < n_procesos; i++) {
-        wait(NULL);
+        // Reenviar token inicial al primero de la lista
+        printf("[Padre] Reenviando token inicial %d al proceso %d\n", argumentos.token_inicial, anillo_miembro(anillo, 0));
+        fflush(stdout);
+        anillo_pasar_token(anillo, 0, evento.id, argumentos.token_inicial);
     }
 
-    free(pids);
-    return 0;
+    if (!hay_ganador) printf("[Padre] El anillo dejo de responder antes de que hubiera un ganador\n");
+    anillo_destruir(anillo);
+    return !hay_ganador;
 }
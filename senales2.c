@@ -1,118 +1,62 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <unistd.h>
-#include <signal.h>
-#include <sys/types.h>
-#include <sys/wait.h>
-#include <string.h>
-#include <time.h>
 
-//Ojo no se hizo que siguiera el proceso, solo sapan token hasta que alguno muera y queda colgada la consola
+#include "tokenring.h"
 
-//--Idea: Se tienen dos tipos de señales, una es la via para pasar el PID(SIGUSR1) y el segundo es la via(SIGUSR2) para pasar el Token con el primer pid enviado
+//--Idea: Se arma el anillo y el token se pasa hasta que alguno muera. No se repara el anillo: al primer
+//eliminado el padre termina a todos (antes la consola quedaba colgada en ese punto)
 //La cantidad de hijos, token y maximo numero aleatorio se deben pasar por consola como: -t token -M maximoNumero -p CantidadPorcesos
 
-pid_t next_pid = -1;       // PID del siguiente proceso en el anillo
-int token = -1;            // Token que será decrementado
-int max_decremento = 0;    // Valor máximo para el decremento aleatorio
+// Callback de cada salto: decrementa el token con un numero aleatorio
+int manejar_token(anillo_salto_t *salto, void *contexto) {
+    const anillo_argumentos_t *argumentos = contexto;
 
-// Manejador para recibir el PID del siguiente proceso (fase inicial)
-void recibir_siguiente(int sig, siginfo_t *info, void *context) {
-    next_pid = info->si_value.sival_int;
-}
-
-// Manejador para recibir el token
-void manejar_token(int sig, siginfo_t *info, void *context) {
-    token = info->si_value.sival_int;
-
-    printf("\nProceso %d ; Token recibido: %d ;", getpid(), token);
-
-    // Generar decremento aleatorio
-    int decremento = rand() % (max_decremento + 1); //Se crea el numero aleatorio
-    token -= decremento;
-
-    printf("Proceso %d le resta %d al token ; Token resultante: %d\n", getpid(), decremento, token);
+    int decremento = rand_r(&salto->semilla) % (argumentos->max_decremento + 1); //Se crea el numero aleatorio
+    int token = salto->valor - decremento;
 
+    anillo_escribir("\nProceso %d ; Token recibido: %d ;Proceso %d le resta %d al token ; Token resultante: %d\n",
+                    salto->yo, salto->valor, salto->yo, decremento, token);
     if (token < 0) {
-        printf("(Proceso %d: el token es negativo. Eliminado)", getpid());
-        exit(0);
-    } else {
-        sigqueue(next_pid, SIGUSR2, (union sigval){ .sival_int = token });
+        anillo_escribir("(Proceso %d: el token es negativo. Eliminado)", salto->yo);
     }
+    return token;
 }
 
 int main(int argc, char *argv[]) {
-    int n_procesos = -1;
+    anillo_argumentos_t argumentos;
+    anillo_evento_t evento;
 
-    int token_inicial;
-    // Buscar argumentos -p (cantidad de procesos), -M (máximo decremento) y -t (token)
-    for (int i = 0; i < argc; i++) {
-        if (strcmp(argv[i], "-p") == 0) {
-            n_procesos = atoi(argv[i + 1]);
-        } else if (strcmp(argv[i], "-M") == 0) {
-            max_decremento = atoi(argv[i + 1]);
-        } else if (strcmp(argv[i], "-t") == 0) {
-            token_inicial = atoi(argv[i + 1]);
-        }
-    }
-
-    if (n_procesos <= 0 || max_decremento <= 0) {
+    if (anillo_leer_argumentos(argc, argv, "pMt", &argumentos) != 0) {
         printf("Cantidad de procesos no especificada o numero no valido\n");
         exit(1);
     }
 
-    pid_t pids[n_procesos];
-    srand(time(NULL)); // Semilla para números aleatorios
-
-    // Configurar recepción del siguiente PID (fase 1)
-    struct sigaction sa_siguiente;
-    sa_siguiente.sa_flags = SA_SIGINFO;
-    sa_siguiente.sa_sigaction = recibir_siguiente;
-    sigemptyset(&sa_siguiente.sa_mask);
-    sigaction(SIGUSR1, &sa_siguiente, NULL);
-
-    // Configurar recepción del token (fase 2)
-    struct sigaction sa_token;
-    sa_token.sa_flags = SA_SIGINFO;
-    sa_token.sa_sigaction = manejar_token;
-    sigemptyset(&sa_token.sa_mask);
-    sigaction(SIGUSR2, &sa_token, NULL);
-
-    for (int i = 0; i < n_procesos; i++) {
-        pid_t pid = fork();
-
-        //Hijo
-        if (pid == 0) {
-            pause(); // Espera el PID del siguiente proceso
-            while (1) {//Hacemos que el while se ejecute de manera infinita y el menjetador fase 2 sea el que contenga el exit(0)
-                pause(); // Espera el token
-            }
-        //Padre    
-        } else if (pid > 0) {
-            pids[i] = pid;
-        //Error de creacion
-        } else {
-            perror("Error en fork, no se pudo crear proceso hijo se detuvo todo");
-            exit(1);
-        }
+    anillo_opciones_t opciones = {
+        .n_procesos = argumentos.n_procesos,
+        .transporte = argumentos.transporte,
+        .lanzador = argumentos.lanzador,
+    };
+    anillo_t *anillo = anillo_crear(&opciones);
+    if (anillo == NULL) {
+        printf("Cantidad de procesos no especificada o numero no valido\n");
+        exit(1);
     }
+    anillo_registrar_callback(anillo, manejar_token, &argumentos);
 
-    // Enviar a cada hijo el PID de su siguiente en el anillo
-    for (int i = 0; i < n_procesos; i++) {
-        pid_t siguiente = pids[(i + 1) % n_procesos];
-        sigqueue(pids[i], SIGUSR1, (union sigval){ .sival_int = siguiente });
+    if (anillo_iniciar(anillo) != 0) {
+        fprintf(stderr, "Error en fork, no se pudo crear proceso hijo se detuvo todo\n");
+        anillo_destruir(anillo);
+        exit(1);
     }
 
-    sleep(1); // Esperar un momento para asegurar que todos los procesos hijos hayan recibido su siguiente PID
-
     // Enviar el token inicial al primer proceso
-    printf("El padre envía el token con valor %d al proceso %d\n", token_inicial, pids[0]);//Print para vizualizar el recorrido
-    sigqueue(pids[0], SIGUSR2, (union sigval){ .sival_int = token_inicial });//Envio del token ingresado por consola
-
-    // Esperar a que todos los hijos terminen
-    for (int i = 0; i < n_procesos; i++) {
-        wait(NULL);
-    }
-
+    printf("El padre envía el token con valor %d al proceso %d\n", argumentos.token_inicial, anillo_miembro(anillo, 0));//Print para vizualizar el recorrido
+    fflush(stdout);
+    anillo_pasar_token(anillo, 0, 0, argumentos.token_inicial);
+
+    // Esperar solo la primera eliminacion y terminar a los demas
+    while (anillo_esperar(anillo, &evento) == 0 && evento.tipo != EVENTO_ELIMINADO);
+    printf("\n");
+    anillo_destruir(anillo);
     return 0;
 }
@@ -0,0 +1,68 @@
+#ifndef SONDAS_H
+#define SONDAS_H
+
+/*
+ * Sondas estaticas (USDT) del anillo de token.
+ *
+ * Cada sonda deja una nota en la seccion .note.stapsdt del ejecutable y un solo "nop" en el codigo,
+ * por lo que mientras nadie se conecte no cuestan nada y no se necesita una version "debug" aparte.
+ * Con bpftrace o perf se pueden listar y usar directamente, por ejemplo:
+ *
+ *     bpftrace -l 'usdt:./desafio1:anillo:*'
+ *     bpftrace -e 'usdt:./desafio1:anillo:token_recibido { @[arg0] = count(); }'
+ *
+ * Todas las sondas llevan tres argumentos enteros: pid, valor del token y numero de ronda. Con el
+ * transporte de señales la ronda que ven los participantes se da vuelta en 65536.
+ *
+ * Si el sistema tiene <sys/sdt.h> (paquete systemtap-sdt-dev) se usa ese encabezado. Si no, en x86_64
+ * se emite la misma nota a mano, y en cualquier otro caso las sondas quedan vacias.
+ */
+
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define SONDAS_CON_SDT 1
+#endif
+#endif
+
+#if defined(SONDAS_CON_SDT)
+
+#define SONDA(nombre, pid, valor, ronda) STAP_PROBE3(anillo, nombre, pid, valor, ronda)
+
+#elif defined(__GNUC__) && defined(__x86_64__)
+
+// Misma nota que genera sys/sdt.h (version 3): direccion del nop, base .stapsdt.base, sin semaforo,
+// proveedor, nombre y descripcion de argumentos ("-4@<operando>" = entero de 4 bytes con signo)
+#define SONDA(nombre, pid, valor, ronda)                                                    \
+    __asm__ __volatile__(                                                                   \
+        "990: nop\n"                                                                        \
+        ".pushsection .note.stapsdt,\"?\",\"note\"\n"                                       \
+        ".balign 4\n"                                                                       \
+        ".4byte 992f-991f, 994f-993f, 3\n"                                                  \
+        "991: .asciz \"stapsdt\"\n"                                                         \
+        "992: .balign 4\n"                                                                  \
+        "993: .8byte 990b\n"                                                                \
+        ".8byte _.stapsdt.base\n"                                                           \
+        ".8byte 0\n"                                                                        \
+        ".asciz \"anillo\"\n"                                                               \
+        ".asciz \"" #nombre "\"\n"                                                          \
+        ".asciz \"-4@%0 -4@%1 -4@%2\"\n"                                                    \
+        "994: .balign 4\n"                                                                  \
+        ".popsection\n"                                                                     \
+        ".ifndef _.stapsdt.base\n"                                                          \
+        ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n"             \
+        ".weak _.stapsdt.base\n"                                                            \
+        ".hidden _.stapsdt.base\n"                                                          \
+        "_.stapsdt.base: .space 1\n"                                                        \
+        ".size _.stapsdt.base, 1\n"                                                         \
+        ".popsection\n"                                                                     \
+        ".endif\n"                                                                          \
+        :: "nor"((int)(pid)), "nor"((int)(valor)), "nor"((int)(ronda)))
+
+#else
+
+#define SONDA(nombre, pid, valor, ronda) ((void)(pid), (void)(valor), (void)(ronda))
+
+#endif
+
+#endif
@@ -0,0 +1,899 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <signal.h>
+#include <string.h>
+#include <sched.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+
+#include "tokenring.h"
+#include "sondas.h"
+
+/*
+ * Autores: Omar Elias Saez Arias y Enzo Ivo San Martin Pavez
+ * Proyecto: Laboratorio de procesos en anillo - Biblioteca comun (libtokenring)
+ *
+ * El padre guarda la lista de miembros vivos en el orden del anillo. Cada participante solo conoce
+ * a su siguiente: recibe el token, le aplica el callback registrado y lo pasa, o si queda negativo
+ * avisa al padre. El padre entonces une al anterior del eliminado con su siguiente.
+ *
+ * Con varios tokens circulando a la vez, al eliminado le pueden seguir llegando tokens que su anterior
+ * mando antes de enterarse del cambio, o que venian de otro eliminado. Por eso el eliminado no termina
+ * de inmediato: devuelve esos tokens al padre (MENSAJE_HUERFANO), que los reenvia al primer miembro
+ * vivo que le seguia, y recien termina cuando el padre le manda MENSAJE_SALIR. El padre lo manda
+ * cuando el anterior confirma el nuevo siguiente: como cada proceso atiende sus mensajes en orden,
+ * todo lo que el anterior le mando al eliminado llego antes que esa confirmacion. Un vecino que
+ * tambien murio ya no reenvia tokens (los devuelve al padre), asi que eliminaciones de vecinos al
+ * mismo tiempo no necesitan ningun orden entre ellas.
+ *
+ * El padre tambien vigila a sus hijos con SIGCHLD, que el transporte le entrega como MENSAJE_HIJOS.
+ * Un participante que muere sin haber sido eliminado queda "caido": el programa lo saca como a un
+ * eliminado (pero sin MENSAJE_SALIR) y vuelve a inyectar los tokens, porque no hay forma de saber
+ * cuales se perdieron con el. Para retirar las copias que si sobrevivieron, el padre recuerda la
+ * ronda de la ultima inyeccion de cada token: una eliminacion o un huerfano con otra ronda es de una
+ * copia vieja. El huerfano se descarta, y a quien dejo negativo una copia vieja el padre le manda
+ * MENSAJE_INDULTO: vuelve a atender tokens y nunca sale del anillo por ella.
+ *
+ * Si un envio no entra (RLIMIT_SIGPENDING o FIFO llena) nadie puede quedarse solo reintentando: si
+ * todos los que tienen mensajes en cola estan intentando enviar, nadie libera lugar. Mientras
+ * reintenta, cada proceso saca sus propios mensajes a un buzon que atiende despues. Si aun asi no hay
+ * lugar durante ESPERA_ENVIO_NS (por ejemplo porque la cuota de señales la ocupa otro programa) el
+ * envio se da por fallido: el participante termina y el padre deja de esperar eventos.
+ *
+ * Los participantes se crean con clone(CLONE_VM) sobre una pila propia de TAMANO_PILA (comparten la
+ * memoria del padre, sin copiar tablas de paginas) o con fork(). La pagina mas baja de cada pila queda
+ * sin permisos: un participante que se pasa muere con SIGSEGV (y el padre lo ve caer) en vez de pisar
+ * en silencio la pila del vecino. Con clone todo el estado de cada
+ * participante vive en su pila, no usa stdio ni malloc (sus buffers, locks y cache serian compartidos)
+ * y termina con _exit(). errno tambien es compartido (los participantes no tienen TLS propio), por lo
+ * que ni la biblioteca ni los transportes lo leen: otro participante lo puede pisar entre la llamada que
+ * fallo y la consulta. Cada falla se distingue por el valor de retorno o con una segunda llamada.
+ *
+ * Las sondas USDT (ver sondas.h) se disparan aca, asi cualquier programa que use la biblioteca las trae.
+ */
+
+#define TAMANO_PILA (64 * 1024)
+
+// Con RLIMIT_NPROC (o sin memoria) fork/clone fallan: se reintenta un rato por si otros procesos
+// terminan, y si no anillo_iniciar falla: un anillo mas chico que el pedido no es el juego pedido. La
+// causa no se mira (errno es compartido con los participantes que ya corren)
+#define REINTENTOS_LANZAMIENTO 25
+#define ESPERA_LANZAMIENTO_US 2000
+
+// Un envio que no entra se reintenta hasta ESPERA_ENVIO_NS. Los primeros reintentos solo ceden la CPU;
+// si siguen sin lugar se duerme entre uno y otro para no tener a todo el anillo girando
+#define ESPERA_ENVIO_NS (10 * 1000000000LL)
+#define REINTENTOS_SIN_DORMIR 100
+#define DORMIR_REINTENTO_US 1000
+
+// Estado de cada participante visto desde el padre
+#define ESTADO_VIVO 0
+#define ESTADO_MURIENDO 1      // eliminado, esperando MENSAJE_SALIR
+#define ESTADO_TERMINADO 2     // ya termino o ya se le mando MENSAJE_SALIR
+#define ESTADO_CAIDO 3         // murio sin ser eliminado, falta que el anterior confirme la reparacion
+#define ESTADO_RECOGIDO 4      // ya se espero con waitpid
+
+// Mensajes que un proceso saco de su canal mientras esperaba lugar para enviar, en orden de llegada
+typedef struct {
+    mensaje_t *mensajes;
+    int n, primero, capacidad;
+    int crece;                // solo el del padre
+} buzon_t;
+
+// Un participante puede tener en cola a lo sumo todos los tokens mas unos pocos mensajes del padre
+#define CAPACIDAD_BUZON_PARTICIPANTE (ANILLO_MAX_TOKENS + 8)
+
+struct anillo {
+    anillo_opciones_t opciones;
+    anillo_callback_t callback;
+    void *contexto;
+
+    pid_t padre;
+    canal_t canal;            // canal del padre
+
+    pid_t *pids;              // miembros vivos, en el orden del anillo
+    int n_vivos;
+    pid_t *lanzados;          // todos los participantes creados, para esperarlos al final
+    char *estados;            // ESTADO_* de cada lanzado
+    int *confirmaciones;      // secuencia de reparacion que debe confirmarse antes de mandarle MENSAJE_SALIR, 0 si ninguna
+    pid_t *sucesores;         // siguiente que tenia al ser sacado del anillo, para reenviar sus huerfanos
+    int n_lanzados;
+    int secuencia;            // ultima secuencia de reparacion usada
+
+    buzon_t buzon;            // mensajes sacados del canal mientras un envio del padre esperaba lugar
+    anillo_evento_t *eventos; // eventos detectados que anillo_esperar aun no entrego
+    int n_eventos, primer_evento, capacidad_eventos;
+
+    char *pilas;              // pilas de los participantes (lanzador clone)
+    size_t largo_pilas;
+    long pss_base_kb;         // PSS del padre antes de armar el anillo, -1 si no se pudo leer
+
+    int atascado;             // un envio del padre no entro en ESPERA_ENVIO_NS: el anillo ya no avanza
+    int ronda;
+    int rondas[ANILLO_MAX_TOKENS + 1];   // ronda de la ultima inyeccion de cada token
+    anillo_evento_t ultimo_evento;
+    anillo_estadisticas_t estadisticas;
+    struct timespec inicio;
+};
+
+// Entradas: instante de referencia
+// Salidas: nanosegundos transcurridos desde ese instante
+// Descripción: Diferencia con CLOCK_MONOTONIC
+static long long nanos_desde(const struct timespec *desde) {
+    struct timespec ahora;
+    clock_gettime(CLOCK_MONOTONIC, &ahora);
+    return (ahora.tv_sec - desde->tv_sec) * 1000000000LL + (ahora.tv_nsec - desde->tv_nsec);
+}
+
+// Entradas: ninguna
+// Salidas: nanosegundos de CLOCK_MONOTONIC
+// Descripción: Marca de tiempo comparable entre procesos (la usa el arnes de estres)
+static long long nanos_monotonico(void) {
+    struct timespec ahora;
+    clock_gettime(CLOCK_MONOTONIC, &ahora);
+    return ahora.tv_sec * 1000000000LL + ahora.tv_nsec;
+}
+
+// Entradas: buzon
+// Salidas: 1 si hay lugar para un mensaje mas
+// Descripción: Primero corre al inicio lo que falta atender (un proceso que envia mientras atiende su buzon puede no vaciarlo nunca). Si aun no hay lugar, el buzon del padre crece con realloc; el de un participante se reserva con mmap la primera vez que hace falta (no puede usar malloc, y en su pila ocuparia paginas en todos)
+static int buzon_con_lugar(buzon_t *buzon) {
+    if (buzon->n < buzon->capacidad) return 1;
+    if (buzon->primero > 0) {
+        buzon->n -= buzon->primero;
+        memmove(buzon->mensajes, buzon->mensajes + buzon->primero, sizeof(mensaje_t) * buzon->n);
+        buzon->primero = 0;
+        return 1;
+    }
+
+    if (!buzon->crece) {
+        if (buzon->mensajes != NULL) return 0;
+        void *memoria = mmap(NULL, sizeof(mensaje_t) * CAPACIDAD_BUZON_PARTICIPANTE, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memoria == MAP_FAILED) return 0;
+        buzon->mensajes = memoria;
+        buzon->capacidad = CAPACIDAD_BUZON_PARTICIPANTE;
+        return 1;
+    }
+
+    int capacidad = buzon->capacidad ? buzon->capacidad * 2 : 64;
+    mensaje_t *mensajes = realloc(buzon->mensajes, sizeof(mensaje_t) * capacidad);
+    if (mensajes == NULL) return 0;
+    buzon->mensajes = mensajes;
+    buzon->capacidad = capacidad;
+    return 1;
+}
+
+// Entradas: canal, buzon del proceso, destino, tipo de mensaje, valor, ronda e id del token
+// Salidas: 0 si se envio, -1 si el destino no existe, TRANSPORTE_LLENO si no hubo lugar en ESPERA_ENVIO_NS
+// Descripción: Arma un mensaje y lo envia. Mientras el transporte esta lleno saca los mensajes propios al buzon: si todos solo reintentaran, nadie liberaria lugar
+static int enviar(canal_t *canal, buzon_t *buzon, pid_t destino, int tipo, int valor, int ronda, int id) {
+    mensaje_t mensaje = { .tipo = tipo, .origen = canal->propio, .valor = valor, .ronda = ronda, .id = id };
+    long long limite = 0;
+    int resultado;
+
+    for (int intento = 0; (resultado = canal->transporte->enviar(canal, destino, &mensaje)) == TRANSPORTE_LLENO; intento++) {
+        while (buzon_con_lugar(buzon) && canal->transporte->recibir(canal, &buzon->mensajes[buzon->n], 0) == 0) {
+            buzon->n++;
+        }
+        if (intento == 0) {
+            limite = nanos_monotonico() + ESPERA_ENVIO_NS;
+        } else if (nanos_monotonico() > limite) {
+            break;
+        }
+        if (intento < REINTENTOS_SIN_DORMIR) {
+            sched_yield();
+        } else {
+            usleep(DORMIR_REINTENTO_US);
+        }
+    }
+    return resultado;
+}
+
+// Entradas: anillo, destino, tipo de mensaje, valor, ronda e id del token
+// Salidas: lo mismo que enviar
+// Descripción: Envio desde el padre. Si no hubo lugar el anillo ya no puede avanzar: queda marcado para que anillo_iniciar y anillo_esperar fallen
+static int enviar_padre(anillo_t *anillo, pid_t destino, int tipo, int valor, int ronda, int id) {
+    int resultado = enviar(&anillo->canal, &anillo->buzon, destino, tipo, valor, ronda, id);
+    if (resultado == TRANSPORTE_LLENO) anillo->atascado = 1;
+    return resultado;
+}
+
+// Entradas: canal, buzon del proceso y mensaje donde dejar lo recibido
+// Salidas: 0 si hay mensaje, -1 si el canal fallo
+// Descripción: Atiende primero lo que quedo en el buzon y despues espera en el canal
+static int recibir(canal_t *canal, buzon_t *buzon, mensaje_t *mensaje) {
+    if (buzon->primero < buzon->n) {
+        *mensaje = buzon->mensajes[buzon->primero++];
+        if (buzon->primero == buzon->n) buzon->primero = buzon->n = 0;
+        return 0;
+    }
+    return canal->transporte->recibir(canal, mensaje, 1) == 0 ? 0 : -1;
+}
+
+// Entradas: anillo, tipo de evento, PID y datos del mensaje que lo causo (o 0)
+// Salidas: ninguna
+// Descripción: Deja un evento para que lo entregue anillo_esperar, en el orden en que se detectaron
+static void encolar_evento(anillo_t *anillo, tipo_evento_t tipo, pid_t pid, int valor, int ronda, int id) {
+    if (anillo->n_eventos == anillo->capacidad_eventos) {
+        int capacidad = anillo->capacidad_eventos ? anillo->capacidad_eventos * 2 : 16;
+        anillo_evento_t *eventos = realloc(anillo->eventos, sizeof(anillo_evento_t) * capacidad);
+        if (eventos == NULL) return;
+        anillo->eventos = eventos;
+        anillo->capacidad_eventos = capacidad;
+    }
+    anillo->eventos[anillo->n_eventos++] = (anillo_evento_t){
+        .tipo = tipo, .pid = pid, .valor = valor, .ronda = ronda, .id = id, .ns = nanos_monotonico(),
+    };
+}
+
+// Entradas: anillo (memoria compartida o copiada del padre)
+// Salidas: ninguna, retorna cuando el participante debe terminar
+// Descripción: Cuerpo de cada participante. Abre su canal, avisa que esta listo y atiende mensajes: nuevo siguiente (que confirma), token o salir. Una vez eliminado devuelve los tokens al padre
+static void participar(anillo_t *anillo) {
+    const transporte_t *transporte = anillo->opciones.transporte;
+    canal_t canal;
+    mensaje_t mensaje;
+    buzon_t buzon = { 0 };
+    int eliminado = 0;
+    anillo_salto_t salto = { .yo = getpid(), .siguiente = -1 };
+    salto.semilla = time(NULL) ^ salto.yo;
+
+    // Si el padre muere antes que el participante, este no debe quedar huerfano esperando mensajes
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+    if (getppid() != anillo->padre) return;
+    if (transporte->abrir(&canal, salto.yo, &anillo->canal) != 0) return;
+
+    // Un envio que no entro ni esperando no va a entrar: el participante termina y el padre lo ve caer
+    int resultado = enviar(&canal, &buzon, anillo->padre, MENSAJE_LISTO, 0, 0, 0);
+
+    while (resultado != TRANSPORTE_LLENO && recibir(&canal, &buzon, &mensaje) == 0) {
+        if (mensaje.tipo == MENSAJE_SIGUIENTE) {
+            salto.siguiente = mensaje.valor;
+            resultado = enviar(&canal, &buzon, anillo->padre, MENSAJE_CONFIRMACION, 0, mensaje.ronda, 0);
+        } else if (mensaje.tipo == MENSAJE_TOKEN && eliminado) {
+            resultado = enviar(&canal, &buzon, anillo->padre, MENSAJE_HUERFANO, mensaje.valor, mensaje.ronda, mensaje.id);
+        } else if (mensaje.tipo == MENSAJE_TOKEN) {
+            salto.valor = mensaje.valor;
+            salto.ronda = mensaje.ronda;
+            salto.id = mensaje.id;
+            SONDA(token_recibido, salto.yo, salto.valor, salto.ronda);
+
+            int nuevo = anillo->callback(&salto, anillo->contexto);
+            SONDA(token_decrementado, salto.yo, nuevo, salto.ronda);
+
+            if (nuevo < 0) {
+                resultado = enviar(&canal, &buzon, anillo->padre, MENSAJE_ELIMINADO, nuevo, salto.ronda, salto.id);
+                eliminado = 1;
+                continue;
+            }
+            SONDA(token_reenviado, salto.yo, nuevo, salto.ronda);
+            resultado = enviar(&canal, &buzon, salto.siguiente, MENSAJE_TOKEN, nuevo, salto.ronda, salto.id);
+        } else if (mensaje.tipo == MENSAJE_SONDEO) {
+            resultado = enviar(&canal, &buzon, anillo->padre, MENSAJE_SONDEO, mensaje.valor, mensaje.ronda, 0);
+        } else if (mensaje.tipo == MENSAJE_INDULTO) {
+            eliminado = 0;
+        } else if (mensaje.tipo == MENSAJE_SALIR) {
+            break;
+        }
+    }
+
+    transporte->cerrar(&canal);
+    // Con clone la memoria es la del padre: lo reservado no se libera solo al terminar
+    if (buzon.mensajes != NULL) munmap(buzon.mensajes, sizeof(mensaje_t) * buzon.capacidad);
+}
+
+// Entradas: anillo
+// Salidas: no retorna
+// Descripción: Punto de entrada de los participantes creados con clone
+static int participar_clone(void *arg) {
+    participar(arg);
+    _exit(0);
+}
+
+// Entradas: anillo y posicion del participante
+// Salidas: PID del participante creado, -1 si fallo
+// Descripción: Crea un participante con el lanzador elegido
+static pid_t lanzar(anillo_t *anillo, int posicion) {
+    if (anillo->opciones.lanzador == LANZADOR_CLONE) {
+        char *pila = anillo->pilas + (size_t)posicion * TAMANO_PILA;
+        return clone(participar_clone, pila + TAMANO_PILA, CLONE_VM | SIGCHLD, anillo);
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        participar(anillo);
+        _exit(0);
+    }
+    return pid;
+}
+
+// Entradas: PID de un proceso
+// Salidas: PSS (Proportional Set Size) de la memoria anonima del proceso en kB, o -1 si no se pudo leer
+// Descripción: Suma "Pss_Anon:" y "Pss_Shmem:" de /proc/<pid>/smaps_rollup. Las paginas de archivos (bibliotecas) se dejan fuera: no las agrega el anillo y la parte que le toca a cada proceso cambia con lo que corra en el resto del sistema. Sin ese detalle (kernels viejos) se usa "Pss:"
+static long leer_pss_kb(pid_t pid) {
+    char ruta[64], linea[128];
+    long pss = -1, anonima = -1, compartida = 0, valor;
+
+    snprintf(ruta, sizeof(ruta), "/proc/%d/smaps_rollup", pid);
+    FILE *archivo = fopen(ruta, "r");
+    if (archivo == NULL) return -1;
+
+    while (fgets(linea, sizeof(linea), archivo) != NULL) {
+        if (sscanf(linea, "Pss: %ld kB", &valor) == 1) pss = valor;
+        if (sscanf(linea, "Pss_Anon: %ld kB", &valor) == 1) anonima = valor;
+        if (sscanf(linea, "Pss_Shmem: %ld kB", &valor) == 1) compartida = valor;
+    }
+    fclose(archivo);
+    return anonima >= 0 ? anonima + compartida : pss;
+}
+
+// Entradas: anillo y PID
+// Salidas: posicion del PID en la lista de lanzados, -1 si no esta
+// Descripción: Busqueda lineal entre todos los participantes creados
+static int indice_lanzado(const anillo_t *anillo, pid_t pid) {
+    for (int i = 0; i < anillo->n_lanzados; i++) {
+        if (anillo->lanzados[i] == pid) return i;
+    }
+    return -1;
+}
+
+// Entradas: anillo y posicion de un participante entre los lanzados
+// Salidas: cantidad de cambios recogidos
+// Descripción: Recoge con waitpid lo que le paso a ese participante (detenido, continuado o muerto) y encola los eventos
+static int revisar_hijo(anillo_t *anillo, int lanzado) {
+    pid_t pid = anillo->lanzados[lanzado];
+    int estado, recogidos = 0;
+
+    while (waitpid(pid, &estado, WNOHANG | WUNTRACED | WCONTINUED) > 0) {
+        recogidos++;
+        if (WIFSTOPPED(estado)) {
+            encolar_evento(anillo, EVENTO_DETENIDO, pid, WSTOPSIG(estado), anillo->ronda, 0);
+            continue;
+        }
+        if (WIFCONTINUED(estado)) {
+            encolar_evento(anillo, EVENTO_CONTINUADO, pid, 0, anillo->ronda, 0);
+            continue;
+        }
+
+        anillo->opciones.transporte->descartar(&anillo->canal, pid);
+        if (anillo->estados[lanzado] == ESTADO_TERMINADO) {
+            anillo->estados[lanzado] = ESTADO_RECOGIDO;
+            break;
+        }
+
+        // Murio sin que se lo pidieran. Si ya estaba eliminado su reparacion esta en curso y solo falta no
+        // esperarlo, pero igual se avisa: los tokens que le llegaban para devolver se perdieron
+        int senal = WIFSIGNALED(estado) ? WTERMSIG(estado) : 0;
+        if (anillo->estados[lanzado] == ESTADO_VIVO) {
+            anillo->estados[lanzado] = ESTADO_CAIDO;
+            anillo->estadisticas.caidos++;
+        } else {
+            anillo->estados[lanzado] = ESTADO_RECOGIDO;
+            anillo->confirmaciones[lanzado] = 0;
+        }
+        SONDA(proceso_caido, pid, senal, anillo->ronda);
+        encolar_evento(anillo, EVENTO_CAIDO, pid, senal, anillo->ronda, 0);
+        break;
+    }
+    return recogidos;
+}
+
+// Entradas: anillo
+// Salidas: ninguna
+// Descripción: Atiende una SIGCHLD (varias se juntan en una). Solo se recoge a los participantes: el estado de cualquier otro hijo del programa es de quien lo creo. waitid con WNOWAIT mira sin recoger cual es el primer hijo con novedades; mientras sea del anillo se lo recoge directo, y si es ajeno (tapa a los demas) se pregunta por cada participante que aun no se recogio
+static void revisar_hijos(anillo_t *anillo) {
+    siginfo_t info;
+
+    while (1) {
+        info.si_pid = 0;
+        if (waitid(P_ALL, 0, &info, WEXITED | WSTOPPED | WCONTINUED | WNOHANG | WNOWAIT) == -1 || info.si_pid == 0) return;
+
+        int lanzado = indice_lanzado(anillo, info.si_pid);
+        if (lanzado == -1 || anillo->estados[lanzado] >= ESTADO_CAIDO) break;
+        if (revisar_hijo(anillo, lanzado) == 0) break;
+    }
+
+    // CAIDO y RECOGIDO ya se esperaron
+    for (int i = 0; i < anillo->n_lanzados; i++) {
+        if (anillo->estados[i] < ESTADO_CAIDO) revisar_hijo(anillo, i);
+    }
+}
+
+// Entradas: opciones (cantidad de procesos, transporte y lanzador)
+// Salidas: anillo sin iniciar, o NULL si las opciones no son validas
+// Descripción: Reserva el anillo. Los participantes se crean en anillo_iniciar
+anillo_t *anillo_crear(const anillo_opciones_t *opciones) {
+    if (opciones->n_procesos <= 1 || opciones->transporte == NULL) return NULL;
+
+    anillo_t *anillo = calloc(1, sizeof(anillo_t));
+    if (anillo == NULL) return NULL;
+
+    anillo->opciones = *opciones;
+    anillo->buzon.crece = 1;
+    anillo->pids = malloc(sizeof(pid_t) * opciones->n_procesos);
+    anillo->lanzados = malloc(sizeof(pid_t) * opciones->n_procesos);
+    anillo->estados = calloc(opciones->n_procesos, 1);
+    anillo->confirmaciones = calloc(opciones->n_procesos, sizeof(int));
+    anillo->sucesores = malloc(sizeof(pid_t) * opciones->n_procesos);
+    if (anillo->pids == NULL || anillo->lanzados == NULL || anillo->estados == NULL ||
+        anillo->confirmaciones == NULL || anillo->sucesores == NULL) {
+        anillo_destruir(anillo);
+        return NULL;
+    }
+    return anillo;
+}
+
+// Entradas: anillo, funcion a aplicar en cada salto y su contexto
+// Salidas: ninguna
+// Descripción: Registra el callback. Debe llamarse antes de anillo_iniciar; el contexto solo se lee desde los participantes
+void anillo_registrar_callback(anillo_t *anillo, anillo_callback_t callback, void *contexto) {
+    anillo->callback = callback;
+    anillo->contexto = contexto;
+}
+
+// Entradas: anillo creado y con callback
+// Salidas: 0 si el anillo quedo armado, -1 si no
+// Descripción: Abre el canal del padre, crea los participantes, espera que todos esten listos y le manda a cada uno su siguiente
+int anillo_iniciar(anillo_t *anillo) {
+    const transporte_t *transporte = anillo->opciones.transporte;
+    int n = anillo->opciones.n_procesos;
+    struct timespec inicio;
+
+    if (anillo->callback == NULL) return -1;
+
+    anillo->padre = getpid();
+    anillo->pss_base_kb = leer_pss_kb(anillo->padre);
+    if (transporte->abrir(&anillo->canal, anillo->padre, NULL) != 0) return -1;
+
+    if (anillo->opciones.lanzador == LANZADOR_CLONE) {
+        // Una sola reserva para todas las pilas. Solo se usan las paginas que se tocan; las de guarda
+        // nunca se tocan y no ocupan memoria
+        size_t pagina = (size_t)sysconf(_SC_PAGESIZE);
+        anillo->largo_pilas = (size_t)n * TAMANO_PILA;
+        anillo->pilas = mmap(NULL, anillo->largo_pilas, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+        if (anillo->pilas == MAP_FAILED) {
+            anillo->pilas = NULL;
+            return -1;
+        }
+        for (int i = 0; i < n; i++) {
+            if (mprotect(anillo->pilas + (size_t)i * TAMANO_PILA, pagina, PROT_NONE) != 0) return -1;
+        }
+    }
+
+    // Lo que quede en el buffer de stdio no debe duplicarse en los hijos de fork
+    fflush(stdout);
+
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
+    for (int i = 0; i < n; i++) {
+        pid_t pid = lanzar(anillo, i);
+        for (int intento = 0; pid == -1 && intento < REINTENTOS_LANZAMIENTO; intento++) {
+            anillo->estadisticas.fallos_lanzamiento++;
+            usleep(ESPERA_LANZAMIENTO_US);
+            pid = lanzar(anillo, i);
+        }
+        if (pid == -1) {
+            anillo->estadisticas.fallos_lanzamiento++;
+            break;
+        }
+        anillo->pids[i] = pid;
+        anillo->lanzados[i] = pid;
+        anillo->n_lanzados++;
+    }
+    n = anillo->n_lanzados;
+    anillo->n_vivos = n;
+    anillo->estadisticas.miembros = n;
+    if (n == 0) return -1;
+
+    // Recien cuando todos pueden recibir se arma el anillo (las confirmaciones de secuencia 0 se ignoran).
+    // Si alguno muere antes de estar listo, o no se alcanzaron a crear todos, no hay anillo que armar;
+    // igual se espera a los demas para que anillo_destruir les pueda mandar MENSAJE_SALIR
+    mensaje_t mensaje;
+    for (int listos = 0; listos + anillo->estadisticas.caidos < n; ) {
+        if (recibir(&anillo->canal, &anillo->buzon, &mensaje) != 0) return -1;
+        if (mensaje.tipo == MENSAJE_LISTO && indice_lanzado(anillo, mensaje.origen) != -1) listos++;
+        if (mensaje.tipo == MENSAJE_HIJOS) revisar_hijos(anillo);
+    }
+    if (n < anillo->opciones.n_procesos || n < 2 || anillo->estadisticas.caidos > 0) return -1;
+    for (int i = 0; i < n; i++) {
+        enviar_padre(anillo, anillo->pids[i], MENSAJE_SIGUIENTE, anillo_miembro(anillo, i + 1), 0, 0);
+    }
+    if (anillo->atascado) return -1;
+
+    anillo->estadisticas.ns_creacion = nanos_desde(&inicio);
+    clock_gettime(CLOCK_MONOTONIC, &anillo->inicio);
+    return 0;
+}
+
+// Entradas: anillo, posicion del miembro que lo recibe, id del token y su valor inicial
+// Salidas: 0 si se envio, -1 si no
+// Descripción: Empieza una ronda nueva mandando el token al miembro en esa posicion
+int anillo_pasar_token(anillo_t *anillo, int posicion, int id, int valor) {
+    pid_t destino = anillo_miembro(anillo, posicion);
+
+    anillo->ronda++;
+    anillo->rondas[id & 0xff] = anillo->ronda;
+    anillo->estadisticas.tokens_inyectados++;
+    SONDA(token_reinyectado, destino, valor, anillo->ronda);
+    return enviar_padre(anillo, destino, MENSAJE_TOKEN, valor, anillo->ronda, id) == 0 ? 0 : -1;
+}
+
+// Entradas: anillo, PID del participante y valor a devolver
+// Salidas: 0 si se envio, -1 si no
+// Descripción: El participante devuelve el sondeo cuando lo atiende, lo que llega como EVENTO_REANUDADO
+int anillo_sondear(anillo_t *anillo, pid_t pid, int valor) {
+    return enviar_padre(anillo, pid, MENSAJE_SONDEO, valor, anillo->ronda, 0) == 0 ? 0 : -1;
+}
+
+// Entradas: anillo y mensaje con un token
+// Salidas: 1 si es una copia vieja de un token que ya se volvio a inyectar
+// Descripción: Compara la ronda del mensaje con la de la ultima inyeccion de ese token (en 16 bits, como viaja con señales)
+static int es_obsoleto(const anillo_t *anillo, const mensaje_t *mensaje) {
+    return ((mensaje->ronda ^ anillo->rondas[mensaje->id & 0xff]) & 0xffff) != 0;
+}
+
+// Entradas: anillo y PID de un participante
+// Salidas: primer miembro vivo despues de el, -1 si el anillo ya no tiene a quien
+// Descripción: Si sigue en el anillo es su siguiente. Si ya salio se sigue la cadena de sucesores guardados al sacarlos, que siempre avanza hacia un miembro vivo
+static pid_t sucesor_vivo(const anillo_t *anillo, pid_t pid) {
+    for (int saltos = 0; saltos <= anillo->n_lanzados; saltos++) {
+        int indice = anillo_indice(anillo, pid);
+        if (indice != -1) return anillo_miembro(anillo, indice + 1);
+
+        int lanzado = indice_lanzado(anillo, pid);
+        if (lanzado == -1) return -1;
+        pid = anillo->sucesores[lanzado];
+        if (anillo_indice(anillo, pid) != -1) return pid;
+    }
+    return -1;
+}
+
+// Entradas: anillo y posicion de un participante entre los lanzados
+// Salidas: ninguna
+// Descripción: Le manda MENSAJE_SALIR. Si el padre ya no logra enviar o este envio no llego (transporte lleno, o con fifo un participante que todavia no creo la suya) se lo termina con SIGKILL, para que anillo_destruir no lo espere para siempre
+static void terminar(anillo_t *anillo, int lanzado) {
+    pid_t pid = anillo->lanzados[lanzado];
+    if (anillo->atascado || enviar_padre(anillo, pid, MENSAJE_SALIR, 0, anillo->ronda, 0) != 0) {
+        kill(pid, SIGKILL);
+    }
+    anillo->estados[lanzado] = ESTADO_TERMINADO;
+}
+
+// Entradas: anillo y secuencia confirmada
+// Salidas: ninguna
+// Descripción: Manda MENSAJE_SALIR a los eliminados que esperaban esa confirmacion. Para un caido avisa EVENTO_REPARADO
+static void confirmar(anillo_t *anillo, int secuencia) {
+    for (int i = 0; i < anillo->n_lanzados; i++) {
+        if (anillo->confirmaciones[i] != secuencia) continue;
+
+        if (anillo->estados[i] == ESTADO_MURIENDO) {
+            terminar(anillo, i);
+        } else if (anillo->estados[i] == ESTADO_CAIDO) {
+            anillo->estados[i] = ESTADO_RECOGIDO;
+            encolar_evento(anillo, EVENTO_REPARADO, anillo->lanzados[i], 0, anillo->ronda, 0);
+        }
+        anillo->confirmaciones[i] = 0;
+    }
+}
+
+// Entradas: anillo y evento donde dejar el resultado
+// Salidas: 0 si hubo un evento, -1 si el canal fallo
+// Descripción: Espera hasta el siguiente evento. Mientras tanto reenvia huerfanos, retira copias viejas de tokens y atiende confirmaciones
+int anillo_esperar(anillo_t *anillo, anillo_evento_t *evento) {
+    mensaje_t mensaje;
+
+    while (1) {
+        if (anillo->primer_evento < anillo->n_eventos) {
+            *evento = anillo->eventos[anillo->primer_evento++];
+            if (anillo->primer_evento == anillo->n_eventos) anillo->primer_evento = anillo->n_eventos = 0;
+            return 0;
+        }
+        if (anillo->atascado) return -1;
+        if (recibir(&anillo->canal, &anillo->buzon, &mensaje) != 0) return -1;
+
+        if (mensaje.tipo == MENSAJE_HIJOS) {
+            revisar_hijos(anillo);
+            continue;
+        }
+
+        int lanzado = indice_lanzado(anillo, mensaje.origen);
+        if (lanzado == -1) {
+            if (anillo->estadisticas.rechazados++ == 0) {
+                encolar_evento(anillo, EVENTO_RECHAZO, mensaje.origen, mensaje.valor, mensaje.ronda, mensaje.id);
+            }
+            continue;
+        }
+
+        if (mensaje.tipo == MENSAJE_CONFIRMACION) {
+            if (mensaje.ronda != 0) confirmar(anillo, mensaje.ronda);
+        } else if (mensaje.tipo == MENSAJE_SONDEO) {
+            encolar_evento(anillo, EVENTO_REANUDADO, mensaje.origen, mensaje.valor, mensaje.ronda, 0);
+        } else if (mensaje.tipo == MENSAJE_HUERFANO) {
+            if (es_obsoleto(anillo, &mensaje)) {
+                anillo->estadisticas.obsoletos++;
+                continue;
+            }
+            // El token sigue su camino como si el eliminado no hubiera estado
+            pid_t destino = sucesor_vivo(anillo, mensaje.origen);
+            if (destino == -1) continue;
+            anillo->estadisticas.huerfanos++;
+            SONDA(token_huerfano, destino, mensaje.valor, mensaje.ronda);
+            enviar_padre(anillo, destino, MENSAJE_TOKEN, mensaje.valor, mensaje.ronda, mensaje.id);
+        } else if (mensaje.tipo == MENSAJE_ELIMINADO && es_obsoleto(anillo, &mensaje)) {
+            // La copia se retira y el participante sigue: mientras tanto devolvio sus tokens como huerfanos
+            anillo->estadisticas.obsoletos++;
+            if (anillo->estados[lanzado] == ESTADO_VIVO) {
+                enviar_padre(anillo, mensaje.origen, MENSAJE_INDULTO, 0, mensaje.ronda, mensaje.id);
+            }
+            encolar_evento(anillo, EVENTO_RETIRADO, mensaje.origen, mensaje.valor, mensaje.ronda, mensaje.id);
+        } else if (mensaje.tipo == MENSAJE_ELIMINADO) {
+            if (anillo->estados[lanzado] == ESTADO_VIVO) anillo->estados[lanzado] = ESTADO_MURIENDO;
+            *evento = (anillo_evento_t){
+                .tipo = EVENTO_ELIMINADO, .pid = mensaje.origen, .valor = mensaje.valor, .ronda = mensaje.ronda,
+                .id = mensaje.id, .ns = nanos_monotonico(),
+            };
+            anillo->ultimo_evento = *evento;
+            SONDA(proceso_eliminado, evento->pid, evento->valor, evento->ronda);
+            return 0;
+        }
+    }
+}
+
+// Entradas: anillo y PID del miembro a sacar
+// Salidas: cantidad de miembros que quedan
+// Descripción: Quita al miembro de la lista y le manda al anterior el nuevo siguiente. El miembro pasa a "muriendo" y recibe MENSAJE_SALIR cuando el anterior confirme
+int anillo_eliminar(anillo_t *anillo, pid_t pid) {
+    int indice = anillo_indice(anillo, pid);
+    if (indice == -1) return anillo->n_vivos;
+
+    pid_t anterior = anillo_miembro(anillo, indice - 1);
+    pid_t siguiente = anillo_miembro(anillo, indice + 1);
+    int lanzado = indice_lanzado(anillo, pid);
+
+    for (int i = indice; i < anillo->n_vivos - 1; i++) {
+        anillo->pids[i] = anillo->pids[i + 1];
+    }
+    anillo->n_vivos--;
+    anillo->sucesores[lanzado] = siguiente;
+    if (anillo->estados[lanzado] == ESTADO_VIVO) anillo->estados[lanzado] = ESTADO_MURIENDO;
+    if (anillo->estados[lanzado] != ESTADO_CAIDO) anillo->estadisticas.eliminados++;
+
+    // Con un solo miembro no hay nada que reparar: el juego termino
+    if (anillo->n_vivos == 1) {
+        if (anillo->estados[lanzado] == ESTADO_CAIDO) {
+            anillo->estados[lanzado] = ESTADO_RECOGIDO;
+            return anillo->n_vivos;
+        }
+        terminar(anillo, lanzado);
+        return anillo->n_vivos;
+    }
+
+    // La secuencia viaja en 16 bits con el transporte de señales, y 0 esta reservado para el armado inicial
+    anillo->secuencia = anillo->secuencia % 0xffff + 1;
+    anillo->confirmaciones[lanzado] = anillo->secuencia;
+    enviar_padre(anillo, anterior, MENSAJE_SIGUIENTE, siguiente, anillo->secuencia, 0);
+
+    int valor = anillo->ultimo_evento.pid == pid ? anillo->ultimo_evento.valor : 0;
+    SONDA(anillo_reparado, anterior, valor, anillo->ronda);
+    return anillo->n_vivos;
+}
+
+// Entradas: anillo
+// Salidas: cantidad de miembros vivos
+// Descripción: Tamaño actual del anillo
+int anillo_miembros(const anillo_t *anillo) {
+    return anillo->n_vivos;
+}
+
+// Entradas: anillo y posicion (puede ser negativa o pasarse del final)
+// Salidas: PID del miembro en esa posicion
+// Descripción: Acceso circular a la lista de miembros
+pid_t anillo_miembro(const anillo_t *anillo, int indice) {
+    int n = anillo->n_vivos;
+    return anillo->pids[((indice % n) + n) % n];
+}
+
+// Entradas: anillo y PID
+// Salidas: posicion del miembro, -1 si no esta en el anillo
+// Descripción: Busqueda lineal en la lista de miembros vivos
+int anillo_indice(const anillo_t *anillo, pid_t pid) {
+    for (int i = 0; i < anillo->n_vivos; i++) {
+        if (anillo->pids[i] == pid) return i;
+    }
+    return -1;
+}
+
+// Entradas: anillo y estructura donde dejar las estadisticas
+// Salidas: ninguna
+// Descripción: Copia los contadores y mide el tiempo y la memoria actuales. La memoria es lo que agrego el anillo: la PSS (anonima) actual del padre y los participantes menos la del padre antes de lanzarlos. Con clone los participantes usan la memoria del padre y ya estan en su PSS; con fork se suma la de cada uno (las paginas que comparten con el padre se reparten entre todos, asi nada se cuenta dos veces)
+void anillo_estadisticas(const anillo_t *anillo, anillo_estadisticas_t *estadisticas) {
+    *estadisticas = anillo->estadisticas;
+    estadisticas->vivos = anillo->n_vivos;
+    estadisticas->ns_transcurridos = nanos_desde(&anillo->inicio);
+
+    estadisticas->pss_kb = leer_pss_kb(anillo->padre);
+    if (estadisticas->pss_kb < 0 || anillo->pss_base_kb < 0) {
+        estadisticas->pss_kb = -1;
+        return;
+    }
+    estadisticas->pss_kb -= anillo->pss_base_kb;
+    if (anillo->opciones.lanzador == LANZADOR_CLONE) return;
+
+    for (int i = 0; i < anillo->n_lanzados; i++) {
+        int termino = anillo->estados[i] >= ESTADO_TERMINADO;
+        long pss = termino ? 0 : leer_pss_kb(anillo->lanzados[i]);
+        if (pss < 0) {
+            estadisticas->pss_kb = -1;
+            return;
+        }
+        estadisticas->pss_kb += pss;
+    }
+}
+
+// Entradas: anillo
+// Salidas: cantidad de participantes que ya terminaron o se les pidio terminar y aun no se esperaron
+// Descripción: Cuenta los que anillo_destruir todavia debe recoger
+static int por_recoger(const anillo_t *anillo) {
+    int cantidad = 0;
+    for (int i = 0; i < anillo->n_lanzados; i++) {
+        if (anillo->estados[i] == ESTADO_TERMINADO) cantidad++;
+    }
+    return cantidad;
+}
+
+// Entradas: anillo (puede estar a medio iniciar)
+// Salidas: ninguna
+// Descripción: Pide terminar a los participantes que queden, espera a todos y libera la memoria. Los que sigan vivos reciben SIGCONT por si alguno quedo detenido
+void anillo_destruir(anillo_t *anillo) {
+    if (anillo == NULL) return;
+    const transporte_t *transporte = anillo->opciones.transporte;
+
+    for (int i = 0; i < anillo->n_lanzados; i++) {
+        if (anillo->estados[i] < ESTADO_TERMINADO) terminar(anillo, i);
+        if (anillo->estados[i] == ESTADO_TERMINADO) kill(anillo->lanzados[i], SIGCONT);
+    }
+
+    // Mientras terminan se sigue vaciando el canal: un participante que le escribe al padre con el
+    // transporte lleno no veria su MENSAJE_SALIR hasta lograr enviar
+    mensaje_t mensaje;
+    while (anillo->canal.transporte != NULL && por_recoger(anillo) > 0 &&
+           transporte->recibir(&anillo->canal, &mensaje, 1) == 0) {
+        if (mensaje.tipo == MENSAJE_HIJOS) revisar_hijos(anillo);
+    }
+    for (int i = 0; i < anillo->n_lanzados; i++) {
+        if (anillo->estados[i] == ESTADO_TERMINADO) {
+            // Si waitpid falla y el hijo sigue existiendo solo pudo ser interrumpido
+            while (waitpid(anillo->lanzados[i], NULL, 0) == -1 && kill(anillo->lanzados[i], 0) == 0);
+        }
+        transporte->descartar(&anillo->canal, anillo->lanzados[i]);
+    }
+
+    if (anillo->canal.transporte != NULL) transporte->cerrar(&anillo->canal);
+    if (anillo->pilas != NULL) munmap(anillo->pilas, anillo->largo_pilas);
+    free(anillo->pids);
+    free(anillo->lanzados);
+    free(anillo->estados);
+    free(anillo->confirmaciones);
+    free(anillo->sucesores);
+    free(anillo->buzon.mensajes);
+    free(anillo->eventos);
+    free(anillo);
+}
+
+// Entradas: nombre del transporte
+// Salidas: transporte con ese nombre, NULL si no existe
+// Descripción: Permite elegir el transporte desde la linea de comandos
+const transporte_t *transporte_por_nombre(const char *nombre) {
+    if (strcmp(nombre, transporte_senales.nombre) == 0) return &transporte_senales;
+    if (strcmp(nombre, transporte_fifo.nombre) == 0) return &transporte_fifo;
+    return NULL;
+}
+
+// Entradas: argumentos de la linea de comandos, letras de los parametros obligatorios y estructura de salida
+// Salidas: 0 si los argumentos son validos, -1 si no (el error ya se imprimio)
+// Descripción: Lectura comun de -p, -M, -t, -k, -s, -m, -R, -T y -L para todos los programas
+int anillo_leer_argumentos(int argc, char *argv[], const char *requeridos, anillo_argumentos_t *argumentos) {
+    argumentos->n_procesos = -1;
+    argumentos->max_decremento = -1;
+    argumentos->token_inicial = -1;
+    argumentos->tokens = 1;
+    argumentos->silencioso = 0;
+    argumentos->metricas = 0;
+    argumentos->reporte = 0;
+    argumentos->transporte = &transporte_senales;
+    argumentos->lanzador = LANZADOR_CLONE;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0) {
+            argumentos->silencioso = 1;
+            continue;
+        } else if (strcmp(argv[i], "-m") == 0) {
+            argumentos->metricas = 1;
+            continue;
+        } else if (strcmp(argv[i], "-R") == 0) {
+            argumentos->reporte = 1;
+            continue;
+        }
+
+        if (i + 1 >= argc) {
+            printf("Error: Falta el valor de %s.\n", argv[i]);
+            return -1;
+        }
+        const char *valor = argv[++i];
+
+        if (strcmp(argv[i - 1], "-p") == 0) {
+            argumentos->n_procesos = atoi(valor);
+            if (argumentos->n_procesos <= 1) {
+                printf("Error: El número de procesos (-p) debe ser mayor que 1.\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i - 1], "-M") == 0) {
+            argumentos->max_decremento = atoi(valor);
+            if (argumentos->max_decremento <= 0) {
+                printf("Error: El decremento máximo (-M) debe ser mayor que 0.\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i - 1], "-t") == 0) {
+            argumentos->token_inicial = atoi(valor);
+            if (argumentos->token_inicial <= 0) {
+                printf("Error: El valor inicial del token (-t) debe ser mayor que 0.\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i - 1], "-k") == 0) {
+            argumentos->tokens = atoi(valor);
+            if (argumentos->tokens < 1 || argumentos->tokens > ANILLO_MAX_TOKENS) {
+                printf("Error: La cantidad de tokens (-k) debe estar entre 1 y %d.\n", ANILLO_MAX_TOKENS);
+                return -1;
+            }
+        } else if (strcmp(argv[i - 1], "-T") == 0) {
+            argumentos->transporte = transporte_por_nombre(valor);
+            if (argumentos->transporte == NULL) {
+                printf("Error: Transporte (-T) desconocido, use senales o fifo.\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i - 1], "-L") == 0) {
+            if (strcmp(valor, "clone") == 0) {
+                argumentos->lanzador = LANZADOR_CLONE;
+            } else if (strcmp(valor, "fork") == 0) {
+                argumentos->lanzador = LANZADOR_FORK;
+            } else {
+                printf("Error: Lanzador (-L) desconocido, use clone o fork.\n");
+                return -1;
+            }
+        } else {
+            printf("Error: Argumento desconocido %s.\n", argv[i - 1]);
+            return -1;
+        }
+    }
+
+    // Verificación final de parámetros
+    if ((strchr(requeridos, 'p') && argumentos->n_procesos == -1) ||
+        (strchr(requeridos, 'M') && argumentos->max_decremento == -1) ||
+        (strchr(requeridos, 't') && argumentos->token_inicial == -1)) {
+        printf("Error: Faltan parámetros obligatorios.\n");
+        return -1;
+    }
+    return 0;
+}
+
+// Entradas: formato y argumentos como printf
+// Salidas: ninguna
+// Descripción: Formatea en un buffer local y lo escribe con una sola llamada a write()
+void anillo_escribir(const char *formato, ...) {
+    char linea[256];
+    va_list argumentos;
+
+    va_start(argumentos, formato);
+    int largo = vsnprintf(linea, sizeof(linea), formato, argumentos);
+    va_end(argumentos);
+
+    if (largo < 0) return;
+    if (largo >= (int)sizeof(linea)) largo = sizeof(linea) - 1;
+    write(STDOUT_FILENO, linea, largo);
+}
@@ -0,0 +1,243 @@
+#ifndef TOKENRING_H
+#define TOKENRING_H
+
+#include <sys/types.h>
+#include <signal.h>
+
+/*
+ * libtokenring: anillo de procesos que se pasan un token, compartido por desafio1 y los prototipos.
+ *
+ * El padre crea el anillo, registra la funcion que cada participante aplica al token en cada salto,
+ * lo inicia y luego atiende los eventos (participantes eliminados) quitando miembros y reinyectando
+ * el token. Como viajan los mensajes entre procesos lo decide un transporte intercambiable
+ * (señales o FIFOs), asi los mismos programas se pueden comparar sobre distintos transportes.
+ *
+ * Pueden circular varios tokens a la vez (cada uno con su id). Un participante eliminado no termina
+ * en el acto: devuelve al padre los tokens que le sigan llegando y solo sale cuando su anterior
+ * confirmo el nuevo siguiente, asi ningun token en vuelo se pierde aunque mueran vecinos a la vez.
+ *
+ * El padre tambien vigila a sus hijos (SIGCHLD): un participante que muere sin haber sido eliminado
+ * (por ejemplo con SIGKILL), o que es detenido y continuado, llega como un evento mas. Los tokens que
+ * tenia se dan por perdidos; el programa los vuelve a inyectar y las copias viejas que aun circulen
+ * (se reconocen por la ronda) se retiran cuando vuelven al padre. Una copia vieja no elimina a nadie:
+ * el participante que dejo negativo sigue en el anillo.
+ *
+ * Uso tipico con un solo token (desafio1.c muestra el caso con varios y los eventos de fallas):
+ *
+ *     anillo_t *anillo = anillo_crear(&opciones);
+ *     anillo_registrar_callback(anillo, decrementar, &contexto);
+ *     if (anillo_iniciar(anillo) != 0) ...;
+ *     anillo_pasar_token(anillo, 0, 0, token_inicial);
+ *     while (anillo_esperar(anillo, &evento) == 0) {
+ *         // Un caido se saca igual que un eliminado; los demas eventos son solo informativos
+ *         if (evento.tipo != EVENTO_ELIMINADO && evento.tipo != EVENTO_CAIDO) continue;
+ *         if (anillo_eliminar(anillo, evento.pid) == 1) break;
+ *         // Tras una eliminacion el token vuelve a empezar; tras una caida puede haberse perdido con el
+ *         // caido, asi que tambien se relanza (si sobrevivio, la copia vieja se retira sola)
+ *         anillo_pasar_token(anillo, 0, 0, token_inicial);
+ *     }
+ *     anillo_destruir(anillo);
+ */
+
+// ---------------------------------------------------------------------------------------------
+// Mensajes y transportes
+// ---------------------------------------------------------------------------------------------
+
+// Tipos de mensaje que circulan entre el padre y los participantes
+typedef enum {
+    MENSAJE_LISTO = 1,   // participante -> padre: ya puede recibir
+    MENSAJE_SIGUIENTE,   // padre -> participante: valor = PID del nuevo siguiente
+    MENSAJE_TOKEN,       // participante/padre -> participante: valor = token
+    MENSAJE_ELIMINADO,   // participante -> padre: valor = token negativo con que murio
+    MENSAJE_SALIR,       // padre -> participante: terminar
+    MENSAJE_CONFIRMACION,// participante -> padre: ya aplico el MENSAJE_SIGUIENTE con esa ronda
+    MENSAJE_HUERFANO,    // participante eliminado -> padre: token que le llego despues de morir
+    MENSAJE_SONDEO,      // padre -> participante -> padre: se devuelve igual apenas el participante lo atiende
+    MENSAJE_INDULTO,     // padre -> participante: lo elimino una copia vieja de un token, sigue en el anillo
+    MENSAJE_HIJOS        // no viaja: el transporte del padre lo entrega cuando llega SIGCHLD
+} tipo_mensaje_t;
+
+// Maxima cantidad de tokens simultaneos (el id viaja en 8 bits)
+#define ANILLO_MAX_TOKENS 255
+
+typedef struct {
+    int tipo;
+    pid_t origen;   // lo completa el transporte al recibir
+    int valor;
+    int ronda;      // en MENSAJE_SIGUIENTE y MENSAJE_CONFIRMACION es el numero de secuencia de la reparacion
+    int id;         // id del token
+} mensaje_t;
+
+#define CANAL_CACHE 2
+
+// Retorno de enviar cuando el destino existe pero no admite mas mensajes por ahora (cola de señales
+// pendientes o FIFO llenas). Quien envia decide si reintenta o atiende primero lo suyo
+#define TRANSPORTE_LLENO 1
+
+// Extremo de un proceso en un transporte. Vive en la pila de cada proceso (no en memoria global)
+// porque con el lanzador clone todos los participantes comparten la memoria.
+typedef struct canal {
+    const struct transporte *transporte;
+    pid_t propio;
+    int fd;                            // FIFO propio (transporte fifo)
+    char directorio[48];               // directorio privado con las FIFOs del anillo (transporte fifo)
+    int vigilar_hijos;                 // el canal tambien entrega MENSAJE_HIJOS (solo el padre)
+    int fd_hijos;                      // signalfd de SIGCHLD (transporte fifo)
+    pid_t destinos[CANAL_CACHE];       // destinos con descriptor abierto (transporte fifo)
+    int fds[CANAL_CACHE];
+    sigset_t mascara_anterior;         // mascara de señales de antes de abrir, cerrar la restaura
+    void (*sigpipe_anterior)(int);     // manejo de SIGPIPE de antes de abrir (transporte fifo)
+} canal_t;
+
+typedef struct transporte {
+    const char *nombre;
+    // Prepara el canal del proceso actual. El padre lo llama con padre NULL antes de lanzar a los
+    // participantes y ademas se entera por el mismo canal de los hijos que mueren o se detienen; cada
+    // participante pasa el canal del padre para encontrar a los demas
+    int (*abrir)(canal_t *canal, pid_t propio, const canal_t *padre);
+    // Envia un mensaje al proceso destino. Retorna 0, TRANSPORTE_LLENO o -1 si el destino ya no existe
+    int (*enviar)(canal_t *canal, pid_t destino, const mensaje_t *mensaje);
+    // Toma el siguiente mensaje dirigido a este proceso, esperandolo si "bloquear". Retorna 0, 1 si no
+    // habia ninguno (solo sin bloquear) o -1 ante un error
+    int (*recibir)(canal_t *canal, mensaje_t *mensaje, int bloquear);
+    // Libera el canal y deja las señales del proceso como estaban antes de abrir
+    void (*cerrar)(canal_t *canal);
+    // Libera lo que haya dejado un proceso que murio sin cerrar su canal (el padre pasa el suyo)
+    void (*descartar)(canal_t *canal, pid_t pid);
+} transporte_t;
+
+extern const transporte_t transporte_senales;
+extern const transporte_t transporte_fifo;
+
+// Busca un transporte por nombre ("senales" o "fifo"). Retorna NULL si no existe
+const transporte_t *transporte_por_nombre(const char *nombre);
+
+// ---------------------------------------------------------------------------------------------
+// Anillo
+// ---------------------------------------------------------------------------------------------
+
+// Con LANZADOR_CLONE (el predeterminado) los participantes corren sobre el TLS del padre: cualquier
+// llamada de libc que falle en un participante escribe el errno del programa que aloja el anillo, en
+// cualquier momento. Mientras el anillo exista (de anillo_iniciar a anillo_destruir) el padre no debe
+// confiar en errno; si lo necesita, que use LANZADOR_FORK
+typedef enum {
+    LANZADOR_CLONE,   // clone(CLONE_VM) sobre una pila pequeña: comparte la memoria (y errno) del padre
+    LANZADOR_FORK     // fork() clasico
+} lanzador_t;
+
+typedef struct {
+    int n_procesos;
+    const transporte_t *transporte;
+    lanzador_t lanzador;      // con LANZADOR_CLONE el errno del padre no es confiable mientras el anillo exista
+} anillo_opciones_t;
+
+// Lo que recibe el callback en cada salto, dentro del participante
+typedef struct {
+    pid_t yo;
+    pid_t siguiente;
+    int valor;
+    int ronda;
+    int id;
+    unsigned int semilla;   // semilla propia del participante para rand_r
+} anillo_salto_t;
+
+// Retorna el nuevo valor del token. Si es negativo el participante queda eliminado. Con el lanzador
+// clone errno es compartido por todos los participantes: el callback no debe depender de el. Tambien
+// corre sobre una pila de 64 kB con una pagina de guarda, de la que la biblioteca usa un par de kB:
+// el callback no debe usar mas de unos 56 kB (buffers locales grandes o recursion profunda). Si se
+// pasa, el participante muere con SIGSEGV y el padre lo informa como EVENTO_CAIDO. Un marco de mas
+// de una pagina puede saltarse la guarda: compilar el callback con -fstack-clash-protection
+typedef int (*anillo_callback_t)(anillo_salto_t *salto, void *contexto);
+
+typedef enum {
+    EVENTO_ELIMINADO = 1,   // un token dejo negativo al participante
+    EVENTO_CAIDO,           // el participante murio sin ser eliminado (sus tokens se perdieron)
+    EVENTO_REPARADO,        // el anterior de un caido ya confirmo su nuevo siguiente
+    EVENTO_DETENIDO,        // el participante fue detenido (SIGSTOP)
+    EVENTO_CONTINUADO,      // el participante detenido siguio (SIGCONT)
+    EVENTO_REANUDADO,       // el participante respondio un anillo_sondear
+    EVENTO_RECHAZO,         // llego el primer mensaje de alguien que no es del anillo (solo se avisa una vez)
+    EVENTO_RETIRADO         // una copia vieja de un token dejo negativo al participante: se retiro y el sigue
+} tipo_evento_t;
+
+typedef struct {
+    tipo_evento_t tipo;
+    pid_t pid;
+    int valor;
+    int ronda;
+    int id;         // token que lo elimino
+    long long ns;   // instante (CLOCK_MONOTONIC) en que el padre lo vio
+} anillo_evento_t;
+
+typedef struct {
+    int miembros;                // participantes lanzados (menos que n_procesos si anillo_iniciar no pudo crearlos)
+    int vivos;
+    int eliminados;
+    int tokens_inyectados;
+    int huerfanos;               // tokens devueltos por eliminados y reenviados por el padre
+    int caidos;                  // participantes que murieron sin ser eliminados
+    int obsoletos;               // copias viejas de tokens retiradas (huerfanos o eliminaciones que no cuentan)
+    int rechazados;              // mensajes de procesos que no son del anillo
+    int fallos_lanzamiento;      // intentos de crear un participante que fallaron (ej: RLIMIT_NPROC)
+    long long ns_creacion;       // lanzamiento y armado del anillo
+    long long ns_transcurridos;  // desde que se inicio el anillo
+    long pss_kb;                 // memoria (PSS) que agrego el anillo (participantes y lo que crecio el padre), -1 si no se pudo leer
+} anillo_estadisticas_t;
+
+typedef struct anillo anillo_t;
+
+anillo_t *anillo_crear(const anillo_opciones_t *opciones);
+void anillo_registrar_callback(anillo_t *anillo, anillo_callback_t callback, void *contexto);
+// Lanza a los participantes, espera que esten listos y les manda su siguiente. Retorna 0, o -1 si no se
+// pudo armar: no se alcanzaron a crear los n_procesos (ver estadisticas.miembros), alguno murio antes de
+// estar listo o el transporte no dejo enviar los mensajes del armado
+int anillo_iniciar(anillo_t *anillo);
+// Manda el token "id" con un valor nuevo al miembro en la posicion indicada. Cada llamada empieza la
+// ronda siguiente (la primera es 1); las copias anteriores de ese token que sigan circulando pasan a
+// ser obsoletas
+int anillo_pasar_token(anillo_t *anillo, int posicion, int id, int valor);
+// Manda un sondeo al participante. Cuando lo atienda (despues de todo lo que ya tenia en cola) llega
+// un EVENTO_REANUDADO con el mismo valor
+int anillo_sondear(anillo_t *anillo, pid_t pid, int valor);
+// Espera el siguiente evento (ver tipo_evento_t). Mientras tanto reenvia los tokens huerfanos, retira
+// las copias viejas y termina a los eliminados cuya reparacion ya fue confirmada. Retorna -1 si el
+// canal fallo o si un envio del padre no encontro lugar en el transporte por varios segundos (por
+// ejemplo con la cuota de señales pendientes ocupada por otro programa): el anillo ya no avanza
+int anillo_esperar(anillo_t *anillo, anillo_evento_t *evento);
+// Saca a un miembro (eliminado o caido) y une a su anterior con su siguiente. Un eliminado recibe
+// MENSAJE_SALIR recien cuando el anterior confirma el cambio. Retorna cuantos miembros quedan
+int anillo_eliminar(anillo_t *anillo, pid_t pid);
+int anillo_miembros(const anillo_t *anillo);
+// Miembro en la posicion indicada, con aritmetica circular (-1 es el ultimo)
+pid_t anillo_miembro(const anillo_t *anillo, int indice);
+// Posicion de un miembro, -1 si no esta en el anillo
+int anillo_indice(const anillo_t *anillo, pid_t pid);
+void anillo_estadisticas(const anillo_t *anillo, anillo_estadisticas_t *estadisticas);
+// Termina a los miembros que queden, los espera y libera todo
+void anillo_destruir(anillo_t *anillo);
+
+// ---------------------------------------------------------------------------------------------
+// Utilidades para los programas
+// ---------------------------------------------------------------------------------------------
+
+typedef struct {
+    int n_procesos;        // -p
+    int max_decremento;    // -M
+    int token_inicial;     // -t
+    int tokens;            // -k, tokens simultaneos
+    int silencioso;        // -s
+    int metricas;          // -m
+    int reporte;           // -R, eventos en formato de maquina (ver estres.c)
+    const transporte_t *transporte;   // -T senales|fifo
+    lanzador_t lanzador;              // -L clone|fork
+} anillo_argumentos_t;
+
+// Lee -p -M -t -k -s -m -R -T -L. "requeridos" indica cuales de p, M, t son obligatorios (ej: "pMt").
+// Retorna 0 si todo es valido, o -1 despues de imprimir el error
+int anillo_leer_argumentos(int argc, char *argv[], const char *requeridos, anillo_argumentos_t *argumentos);
+
+// printf que escribe con una sola llamada a write(). Es la forma segura de imprimir desde el
+// callback: con el lanzador clone el buffer y el lock de stdio serian compartidos
+void anillo_escribir(const char *formato, ...);
+
+#endif
@@ -0,0 +1,223 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <sys/signalfd.h>
+
+#include "tokenring.h"
+
+/*
+ * Transporte por FIFOs: cada proceso tiene su propia FIFO de la que lee, y escribe los mensajes en la
+ * FIFO del destino.
+ *
+ * Las FIFOs del anillo viven en un directorio que crea el padre con mkdtemp (/tmp/tokenring-<pid>-XXXXXX,
+ * permisos 0700) y que los participantes conocen por el canal del padre. Nadie mas puede crear ni
+ * reemplazar archivos ahi, asi que cada proceso crea su FIFO sin aceptar una que ya exista y nunca
+ * sigue enlaces simbolicos al abrirlas.
+ *
+ * Cada mensaje es un mensaje_t completo; como es mucho mas chico que PIPE_BUF la escritura es
+ * atomica aunque varios procesos escriban a la vez. El dueño abre su FIFO en lectura y escritura
+ * para que nunca vea fin de archivo ni se bloquee al abrirla. Los descriptores hacia los ultimos
+ * destinos quedan abiertos en el canal (normalmente el siguiente y el padre) y no bloquean: si la
+ * FIFO del destino esta llena se avisa TRANSPORTE_LLENO y quien envia decide que hacer.
+ *
+ * El padre bloquea SIGCHLD y la lee de un signalfd, esperando con poll() la FIFO y ese descriptor a
+ * la vez.
+ *
+ * Con el lanzador clone todos los procesos comparten errno, asi que aca nunca se lee: cada falla se
+ * distingue por el valor de retorno o preguntando de nuevo (poll).
+ */
+
+// Entradas: buffer, su tamaño, canal y PID
+// Salidas: ninguna
+// Descripción: Arma la ruta de la FIFO de un proceso dentro del directorio del anillo
+static void ruta_fifo(char *ruta, size_t largo, const canal_t *canal, pid_t pid) {
+    snprintf(ruta, largo, "%s/%d", canal->directorio, pid);
+}
+
+// Entradas: canal del proceso, su PID y canal del padre (NULL si es el padre, que vigila a sus hijos)
+// Salidas: 0 si se creo la FIFO, -1 si no
+// Descripción: Crea y abre la FIFO propia; el padre crea antes el directorio del anillo. Ignora SIGPIPE para que escribir a un proceso muerto sea un error y no la muerte del que escribe. Lo que cambia en las señales queda guardado en el canal para que cerrar lo restaure
+static int abrir(canal_t *canal, pid_t propio, const canal_t *padre) {
+    char ruta[64];
+
+    canal->transporte = &transporte_fifo;
+    canal->propio = propio;
+    canal->fd = -1;
+    canal->directorio[0] = '\0';
+    canal->vigilar_hijos = padre == NULL;
+    canal->fd_hijos = -1;
+    for (int i = 0; i < CANAL_CACHE; i++) {
+        canal->destinos[i] = -1;
+        canal->fds[i] = -1;
+    }
+    sigprocmask(SIG_BLOCK, NULL, &canal->mascara_anterior);
+    canal->sigpipe_anterior = signal(SIGPIPE, SIG_IGN);
+
+    if (padre == NULL) {
+        snprintf(canal->directorio, sizeof(canal->directorio), "/tmp/tokenring-%d-XXXXXX", propio);
+        if (mkdtemp(canal->directorio) == NULL) {
+            canal->directorio[0] = '\0';
+            return -1;
+        }
+    } else {
+        snprintf(canal->directorio, sizeof(canal->directorio), "%s", padre->directorio);
+    }
+
+    ruta_fifo(ruta, sizeof(ruta), canal, propio);
+    if (mkfifo(ruta, 0600) == -1) return -1;
+    canal->fd = open(ruta, O_RDWR | O_NOFOLLOW);
+    if (canal->fd == -1) return -1;
+
+    if (canal->vigilar_hijos) {
+        sigset_t senales;
+        sigemptyset(&senales);
+        sigaddset(&senales, SIGCHLD);
+        sigprocmask(SIG_BLOCK, &senales, NULL);
+        canal->fd_hijos = signalfd(-1, &senales, SFD_NONBLOCK | SFD_CLOEXEC);
+        if (canal->fd_hijos == -1) return -1;
+    }
+    return 0;
+}
+
+// Entradas: canal, posicion del cache
+// Salidas: ninguna
+// Descripción: Cierra un descriptor del cache
+static void olvidar(canal_t *canal, int posicion) {
+    if (canal->fds[posicion] != -1) close(canal->fds[posicion]);
+    canal->destinos[posicion] = -1;
+    canal->fds[posicion] = -1;
+}
+
+// Entradas: canal y PID destino
+// Salidas: descriptor abierto hacia la FIFO del destino, -1 si no existe
+// Descripción: Busca el descriptor en el cache. Si no esta, abre la FIFO y reemplaza la entrada mas antigua
+static int descriptor_hacia(canal_t *canal, pid_t destino) {
+    for (int i = 0; i < CANAL_CACHE; i++) {
+        if (canal->destinos[i] == destino) return canal->fds[i];
+    }
+
+    char ruta[64];
+    ruta_fifo(ruta, sizeof(ruta), canal, destino);
+    int fd = open(ruta, O_WRONLY | O_NONBLOCK | O_NOFOLLOW);
+    if (fd == -1) return -1;
+
+    olvidar(canal, CANAL_CACHE - 1);
+    for (int i = CANAL_CACHE - 1; i > 0; i--) {
+        canal->destinos[i] = canal->destinos[i - 1];
+        canal->fds[i] = canal->fds[i - 1];
+    }
+    canal->destinos[0] = destino;
+    canal->fds[0] = fd;
+    return fd;
+}
+
+// Entradas: canal, PID destino y mensaje
+// Salidas: 0 si se escribio, TRANSPORTE_LLENO si la FIFO esta llena, -1 si el destino no existe o ya no lee
+// Descripción: Escribe el mensaje completo en la FIFO del destino (sin bloquear, o todo o nada por ser menor que PIPE_BUF). Si no entro, poll distingue una FIFO sin lector (POLLERR) de una llena
+static int enviar(canal_t *canal, pid_t destino, const mensaje_t *mensaje) {
+    mensaje_t copia = *mensaje;
+    copia.origen = canal->propio;
+
+    int fd = descriptor_hacia(canal, destino);
+    if (fd == -1) return -1;
+
+    ssize_t escrito = write(fd, &copia, sizeof(copia));
+    if (escrito == -1) {
+        struct pollfd destino_fd = { .fd = fd, .events = POLLOUT };
+        if (poll(&destino_fd, 1, 0) != -1 && !(destino_fd.revents & (POLLERR | POLLNVAL))) return TRANSPORTE_LLENO;
+    }
+    if (escrito != sizeof(copia)) {
+        for (int i = 0; i < CANAL_CACHE; i++) {
+            if (canal->destinos[i] == destino) olvidar(canal, i);
+        }
+        return -1;
+    }
+    return 0;
+}
+
+// Entradas: canal
+// Salidas: 1 si habia alguna SIGCHLD pendiente
+// Descripción: Vacia el signalfd. Varias muertes seguidas pueden juntarse en una sola SIGCHLD, por eso quien recibe MENSAJE_HIJOS revisa a todos sus hijos
+static int vaciar_hijos(canal_t *canal) {
+    struct signalfd_siginfo info;
+    int hubo = 0;
+    while (read(canal->fd_hijos, &info, sizeof(info)) == sizeof(info)) hubo = 1;
+    return hubo;
+}
+
+// Entradas: canal, mensaje donde dejar lo recibido y si se espera
+// Salidas: 0 si llego un mensaje, 1 si no habia ninguno (sin bloquear), -1 ante un error
+// Descripción: Lee el siguiente mensaje de la FIFO propia. El padre espera con poll() tambien a SIGCHLD. Un poll o read que falla solo pudo ser interrumpido (los descriptores son propios), y se reintenta
+static int recibir(canal_t *canal, mensaje_t *mensaje, int bloquear) {
+    struct pollfd esperados[2] = {
+        { .fd = canal->fd, .events = POLLIN },
+        { .fd = canal->fd_hijos, .events = POLLIN },
+    };
+    int n_esperados = canal->fd_hijos != -1 ? 2 : 1;
+    ssize_t leido;
+
+    // Un participante solo espera su FIFO: basta con el read bloqueante
+    while (n_esperados == 2 || !bloquear) {
+        int listos = poll(esperados, n_esperados, bloquear ? -1 : 0);
+        if (listos == -1) continue;
+        if (listos == 0) return 1;
+
+        if (n_esperados == 2 && (esperados[1].revents & POLLIN) && vaciar_hijos(canal)) {
+            mensaje->tipo = MENSAJE_HIJOS;
+            mensaje->origen = 0;
+            return 0;
+        }
+        if (esperados[0].revents & POLLIN) break;
+    }
+
+    do {
+        leido = read(canal->fd, mensaje, sizeof(*mensaje));
+    } while (leido == -1);
+
+    return leido == sizeof(*mensaje) ? 0 : -1;
+}
+
+// Entradas: canal
+// Salidas: ninguna
+// Descripción: Cierra todos los descriptores, borra la FIFO propia (y el padre el directorio del anillo) y restaura la mascara de señales y el manejo de SIGPIPE
+static void cerrar(canal_t *canal) {
+    char ruta[64];
+
+    for (int i = 0; i < CANAL_CACHE; i++) olvidar(canal, i);
+    if (canal->fd != -1) close(canal->fd);
+    if (canal->fd_hijos != -1) close(canal->fd_hijos);
+    canal->fd = -1;
+    canal->fd_hijos = -1;
+
+    if (canal->directorio[0] != '\0') {
+        ruta_fifo(ruta, sizeof(ruta), canal, canal->propio);
+        unlink(ruta);
+        if (canal->vigilar_hijos) rmdir(canal->directorio);
+    }
+
+    sigprocmask(SIG_SETMASK, &canal->mascara_anterior, NULL);
+    if (canal->sigpipe_anterior != SIG_ERR) signal(SIGPIPE, canal->sigpipe_anterior);
+}
+
+// Entradas: canal del padre y PID de un proceso muerto
+// Salidas: ninguna
+// Descripción: Borra la FIFO que haya dejado un proceso que no alcanzo a cerrar su canal
+static void descartar(canal_t *canal, pid_t pid) {
+    char ruta[64];
+    if (canal->directorio[0] == '\0') return;
+    ruta_fifo(ruta, sizeof(ruta), canal, pid);
+    unlink(ruta);
+}
+
+const transporte_t transporte_fifo = {
+    .nombre = "fifo",
+    .abrir = abrir,
+    .enviar = enviar,
+    .recibir = recibir,
+    .cerrar = cerrar,
+    .descartar = descartar,
+};
@@ -0,0 +1,141 @@
+#include <signal.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tokenring.h"
+
+/*
+ * Transporte por señales: cada mensaje es un sigqueue() de SIGRTMIN.
+ *
+ * A diferencia de SIGUSR1/SIGUSR2, las señales de tiempo real se encolan (no se pierden si llegan
+ * varias juntas) y, al usar una sola, llegan en el mismo orden en que se mandaron. La señal queda
+ * bloqueada en todos los procesos y se recibe con sigwaitinfo(), sin manejadores.
+ *
+ * El mensaje va empaquetado en el sigval: token en los 32 bits bajos, ronda en los 16 siguientes
+ * (se da vuelta en 65536), id del token en los 8 siguientes y el tipo en los 8 altos. El origen es
+ * el si_pid que pone el kernel.
+ *
+ * El padre ademas bloquea SIGCHLD y la espera en el mismo sigwaitinfo, asi la muerte de un hijo no se
+ * puede perder entre que revisa y se pone a esperar. Como SIGCHLD tiene numero menor que SIGRTMIN el
+ * kernel la entrega primero.
+ *
+ * Con el lanzador clone todos los procesos comparten errno, asi que aca nunca se lee: cada falla se
+ * distingue por el valor de retorno o con una segunda llamada.
+ */
+
+#if UINTPTR_MAX < UINT64_MAX
+#error "El transporte de señales necesita punteros de 64 bits para empaquetar el mensaje"
+#endif
+
+// Entradas: mensaje a empaquetar
+// Salidas: sigval con tipo, id, ronda y valor
+// Descripción: Arma la carga de 64 bits que viaja con sigqueue
+static union sigval empaquetar(const mensaje_t *mensaje) {
+    uint64_t carga = ((uint64_t)(uint8_t)mensaje->tipo << 56)
+                   | ((uint64_t)(uint8_t)mensaje->id << 48)
+                   | ((uint64_t)(uint16_t)mensaje->ronda << 32)
+                   | (uint32_t)mensaje->valor;
+    return (union sigval){ .sival_ptr = (void *)(uintptr_t)carga };
+}
+
+// Entradas: sigval recibido y mensaje donde dejar el resultado
+// Salidas: ninguna
+// Descripción: Operacion inversa a empaquetar
+static void desempaquetar(union sigval valor, mensaje_t *mensaje) {
+    uint64_t carga = (uint64_t)(uintptr_t)valor.sival_ptr;
+    mensaje->tipo = (int)(carga >> 56);
+    mensaje->id = (int)((carga >> 48) & 0xff);
+    mensaje->ronda = (int)((carga >> 32) & 0xffff);
+    mensaje->valor = (int)(uint32_t)carga;
+}
+
+// Entradas: canal y conjunto a llenar
+// Salidas: ninguna
+// Descripción: Señales que atiende el canal: SIGRTMIN y, si vigila a sus hijos, SIGCHLD
+static void senales_del_canal(const canal_t *canal, sigset_t *senales) {
+    sigemptyset(senales);
+    sigaddset(senales, SIGRTMIN);
+    if (canal->vigilar_hijos) sigaddset(senales, SIGCHLD);
+}
+
+// Entradas: canal del proceso, su PID y canal del padre (NULL si es el padre, que vigila a sus hijos)
+// Salidas: 0
+// Descripción: Bloquea las señales del canal para recibirlas solo con sigwaitinfo, guardando la mascara anterior. Los hijos heredan la mascara, asi nada se pierde antes de que abran su canal
+static int abrir(canal_t *canal, pid_t propio, const canal_t *padre) {
+    sigset_t senales;
+
+    canal->transporte = &transporte_senales;
+    canal->propio = propio;
+    canal->fd = -1;
+    canal->fd_hijos = -1;
+    canal->vigilar_hijos = padre == NULL;
+
+    senales_del_canal(canal, &senales);
+    sigprocmask(SIG_BLOCK, &senales, &canal->mascara_anterior);
+    return 0;
+}
+
+// Entradas: canal, PID destino y mensaje
+// Salidas: 0 si se encolo, TRANSPORTE_LLENO si se alcanzo RLIMIT_SIGPENDING, -1 si el destino no existe
+// Descripción: Manda el mensaje con sigqueue. Si falla y el destino sigue existiendo, lo unico que pudo pasar es que la cola estaba llena
+static int enviar(canal_t *canal, pid_t destino, const mensaje_t *mensaje) {
+    if (sigqueue(destino, SIGRTMIN, empaquetar(mensaje)) == 0) return 0;
+    return kill(destino, 0) == 0 ? TRANSPORTE_LLENO : -1;
+}
+
+// Entradas: canal, mensaje donde dejar lo recibido y si se espera
+// Salidas: 0 si llego un mensaje, 1 si no habia ninguno (sin bloquear)
+// Descripción: Toma la siguiente SIGRTMIN (o SIGCHLD si vigila a sus hijos). Descarta las SIGRTMIN que no vienen de sigqueue (por ejemplo un kill desde la consola). Con las señales bloqueadas sigwaitinfo solo falla si la interrumpen, y entonces se vuelve a esperar
+static int recibir(canal_t *canal, mensaje_t *mensaje, int bloquear) {
+    static const struct timespec sin_espera = { 0, 0 };
+    sigset_t senales;
+    siginfo_t info;
+    senales_del_canal(canal, &senales);
+
+    while (1) {
+        int senal = bloquear ? sigwaitinfo(&senales, &info) : sigtimedwait(&senales, &info, &sin_espera);
+        if (senal == -1) {
+            if (bloquear) continue;
+            return 1;
+        }
+        if (senal == SIGCHLD) {
+            mensaje->tipo = MENSAJE_HIJOS;
+            mensaje->origen = 0;
+            return 0;
+        }
+        if (info.si_code != SI_QUEUE) continue;
+
+        desempaquetar(info.si_value, mensaje);
+        mensaje->origen = info.si_pid;
+        return 0;
+    }
+}
+
+// Entradas: canal
+// Salidas: ninguna
+// Descripción: Descarta los mensajes que quedaron pendientes (desbloqueada, una SIGRTMIN terminaria el proceso) y restaura la mascara anterior. Una SIGCHLD pendiente se deja para quien la esperaba antes
+static void cerrar(canal_t *canal) {
+    static const struct timespec sin_espera = { 0, 0 };
+    sigset_t senales;
+    siginfo_t info;
+
+    sigemptyset(&senales);
+    sigaddset(&senales, SIGRTMIN);
+    while (sigtimedwait(&senales, &info, &sin_espera) != -1);
+    sigprocmask(SIG_SETMASK, &canal->mascara_anterior, NULL);
+}
+
+// Entradas: canal del padre y PID de un proceso muerto
+// Salidas: ninguna
+// Descripción: Las señales pendientes de un proceso muerto las libera el kernel
+static void descartar(canal_t *canal, pid_t pid) {
+}
+
+const transporte_t transporte_senales = {
+    .nombre = "senales",
+    .abrir = abrir,
+    .enviar = enviar,
+    .recibir = recibir,
+    .cerrar = cerrar,
+    .descartar = descartar,
+};